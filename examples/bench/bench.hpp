@@ -0,0 +1,83 @@
+#ifndef _BENCH_HPP_
+#define _BENCH_HPP_
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "util.hpp"
+
+//-----------------------------------------------------------------------------
+/** prevent the compiler from optimizing away the computation of a value */
+template< class T >
+inline void do_not_optimize(T const& val)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(val) : "memory");
+#else
+    static volatile T sink;
+    sink = val;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/** A minimal benchmark runner. Each benchmark is a function doing a batch
+ * of num_items operations; the function is called repeatedly until
+ * min_time seconds have passed, and the time per item is reported, one
+ * row per benchmark. Benchmarks are identified by name/strategy/case,
+ * and can be selected with a substring filter. */
+class Bench
+{
+public:
+
+    double min_time = 0.1;          //< seconds per benchmark
+    const char *filter = nullptr;   //< run only the benchmarks containing this
+    bool csv = false;               //< output comma-separated values
+
+    void header()
+    {
+        if(csv)
+            printf("benchmark,strategy,case,ns_per_item,Mitems_per_s,MB_per_s\n");
+        else
+            printf("%-16s %-8s %-14s %12s %12s %10s\n",
+                   "benchmark", "strategy", "case", "ns/item", "Mitems/s", "MB/s");
+    }
+
+    /** @param num_items the number of items processed by each call to fn
+     * @param num_bytes the number of bytes processed by each call to fn,
+     *        or 0 if not applicable */
+    template< class Fn >
+    void run(const char *name, const char *strategy, const char *case_,
+             size_t num_items, size_t num_bytes, Fn &&fn)
+    {
+        char id[256];
+        snprintf(id, sizeof(id), "%s/%s/%s", name, strategy, case_);
+        if(filter && ! strstr(id, filter))
+            return;
+        using clock = std::chrono::steady_clock;
+        fn(); // warm up
+        size_t iters = 0;
+        double elapsed = 0;
+        auto start = clock::now();
+        do
+        {
+            fn();
+            ++iters;
+            elapsed = std::chrono::duration< double >(clock::now() - start).count();
+        } while(elapsed < min_time);
+        double ns = 1.e9 * elapsed / double(iters * num_items);
+        double mitems = 1.e3 / ns;
+        double mb = num_bytes ? 1.e-6 * double(iters * num_bytes) / elapsed : 0.;
+        if(csv)
+            printf("%s,%s,%s,%.3f,%.3f,%.3f\n", name, strategy, case_, ns, mitems, mb);
+        else if(num_bytes)
+            printf("%-16s %-8s %-14s %12.2f %12.2f %10.1f\n", name, strategy, case_, ns, mitems, mb);
+        else
+            printf("%-16s %-8s %-14s %12.2f %12.2f %10s\n", name, strategy, case_, ns, mitems, "-");
+        fflush(stdout);
+    }
+
+};
+
+#endif // _BENCH_HPP_
@@ -0,0 +1,17 @@
+#ifndef _BENCH_ARCHIVE_HPP_
+#define _BENCH_ARCHIVE_HPP_
+
+#include <stdint.h>
+#include "reflect.hpp"
+#include "serialize.hpp"
+
+struct Particle
+{
+    C4_CLASS()
+    float x, y, z;
+    float vx, vy, vz;
+    int32_t id;
+    C4_DECLARE_SERIALIZE_METHOD()
+};
+
+#endif // _BENCH_ARCHIVE_HPP_
@@ -0,0 +1 @@
+../common/include/bitmask.hpp
\ No newline at end of file
@@ -0,0 +1 @@
+../common/include/enum.hpp
\ No newline at end of file
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Write the enum headers for the benchmarks: for each generator strategy,
+a file bench_enums_<strategy>.hpp with enums of several sizes, with dense
+and with sparse values, and a bitmask. The enums of each strategy have
+the strategy as a prefix (eg phash_Dense1000), so that all the strategies
+can be linked in the same executable and compared against each other.
+Also writes bench_enums.hpp, which includes the generated headers and
+lists the benchmark cases for main.cpp.
+
+usage: inputs.py [strategy...]
+
+Prints the list of the written enum headers (to be reflected).
+"""
+
+import sys
+import random
+
+
+# the EnumGenerator options for each strategy
+strategies = {
+    'linear': dict(str2e='linear', e2str='linear', bitmask='linear'),
+    'phash': dict(),
+    'lut': dict(bitmask='lut'),
+    'trie': dict(str2e='trie'),
+    'pool': dict(names='pool'),
+    'cexpr': dict(storage='constexpr'),
+}
+
+# the number of symbols of the enums
+sizes = (8, 100, 1000, 10000)
+
+# the largest enum size for each strategy, where it is smaller than the
+# largest of the sizes above. The switches emitted for the trie grow with
+# the number of spellings, and with 10000 symbols take many minutes to compile.
+max_sizes = {
+    'trie': 1000,
+}
+
+# the number of bits of the bitmasks
+bitmask_bits = 32
+
+
+def strategy_of(filename):
+    """get the strategy from the name of a file written by this script"""
+    for s in strategies:
+        if filename.endswith('bench_enums_' + s + '.hpp'):
+            return s
+    return None
+
+
+def strategy_sizes(strategy):
+    """get the enum sizes used with a strategy"""
+    m = max_sizes.get(strategy, sizes[-1])
+    return [sz for sz in sizes if sz <= m]
+
+
+def symbol_names(rng, num, prefix='E_'):
+    alphabet = 'ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_'
+    names = []
+    seen = set()
+    while len(names) < num:
+        n = prefix + rng.choice(alphabet[:26]) + ''.join(
+            rng.choice(alphabet) for _ in range(rng.randint(2, 23)))
+        if n not in seen:
+            seen.add(n)
+            names.append(n)
+    return names
+
+
+def write_enum(out, name, names, values, underlying='int32_t'):
+    out.append('C4_ENUM()')
+    out.append('enum class {} : {} {{'.format(name, underlying))
+    for n, v in zip(names, values):
+        out.append('    {} = {},'.format(n, v))
+    out.append('};')
+    out.append('')
+
+
+def write_strategy(strategy):
+    out = [
+        '// GENERATED AUTOMATICALLY by inputs.py. DO NOT EDIT.',
+        '#ifndef _BENCH_ENUMS_{}_HPP_'.format(strategy.upper()),
+        '#define _BENCH_ENUMS_{}_HPP_'.format(strategy.upper()),
+        '',
+        '#include "reflect.hpp"',
+        '#include "enum.hpp"',
+        '#include "bitmask.hpp"',
+        '',
+    ]
+    for sz in strategy_sizes(strategy):
+        # use the same names and values for all strategies
+        rng = random.Random(sz)
+        names = symbol_names(rng, sz)
+        write_enum(out, '{}_Dense{}'.format(strategy, sz), names, range(sz))
+        values = []
+        v = -sz
+        for _ in range(sz):
+            values.append(v)
+            v += rng.randint(2, 1000)
+        write_enum(out, '{}_Sparse{}'.format(strategy, sz), names, values)
+    # single-bit flags, plus some composites
+    names = ['BM_NONE'] + ['BM_F{}'.format(i) for i in range(bitmask_bits)]
+    values = ['0'] + ['UINT32_C(1) << {}'.format(i) for i in range(bitmask_bits)]
+    for i in range(0, bitmask_bits, 8):
+        names.append('BM_F{}_TO_F{}'.format(i, i + 3))
+        values.append('UINT32_C(0xf) << {}'.format(i))
+    write_enum(out, '{}_Flags{}'.format(strategy, bitmask_bits), names, values,
+               'uint32_t')
+    out.append('#endif // _BENCH_ENUMS_{}_HPP_'.format(strategy.upper()))
+    fn = 'bench_enums_{}.hpp'.format(strategy)
+    with open(fn, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+    return fn
+
+
+def write_cases(chosen):
+    out = [
+        '// GENERATED AUTOMATICALLY by inputs.py. DO NOT EDIT.',
+        '#ifndef _BENCH_ENUMS_HPP_',
+        '#define _BENCH_ENUMS_HPP_',
+        '',
+    ]
+    for s in chosen:
+        out.append('#include "bench_enums_{}.gen.hpp"'.format(s))
+    out.append('')
+    out.append('/** X(strategy, kind, size) */')
+    out.append('#define BENCH_ENUMS(X) \\')
+    for s in chosen:
+        for sz in strategy_sizes(s):
+            for kind in ('Dense', 'Sparse'):
+                out.append('    X({}, {}, {}) \\'.format(s, kind, sz))
+    out.append('')
+    out.append('')
+    out.append('/** X(strategy, bits) */')
+    out.append('#define BENCH_BITMASKS(X) \\')
+    for s in chosen:
+        out.append('    X({}, {}) \\'.format(s, bitmask_bits))
+    out.append('')
+    out.append('')
+    out.append('#endif // _BENCH_ENUMS_HPP_')
+    with open('bench_enums.hpp', 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+# -----------------------------------------------------------------------------
+if __name__ == "__main__":
+    chosen = sys.argv[1:] if len(sys.argv) > 1 else list(strategies.keys())
+    for s in chosen:
+        if s not in strategies:
+            raise Exception("{}: unknown strategy. Must be one of {}".format(
+                s, ",".join(strategies.keys())))
+    files = [write_strategy(s) for s in chosen]
+    write_cases(chosen)
+    print(";".join(files))
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include "bench.hpp"
+#include "bench_enums.hpp"
+#include "bench_archive.gen.hpp"
+
+/* Benchmarks for the code generated by regen for enum.hpp, bitmask.hpp and
+ * serialize.hpp. The enums are written by inputs.py, for each generator
+ * strategy. usage:
+ *
+ *     bench [--csv] [--min-time <seconds>] [filter]
+ *
+ * where filter selects the benchmarks by a substring of their
+ * benchmark/strategy/case identifier, eg e2str/phash/Dense100 */
+
+#define NUM_LOOKUPS 4096 // must be a power of 2
+#define NUM_MASKS 1024
+#define NUM_PARTICLES 4096
+
+//-----------------------------------------------------------------------------
+template< class E >
+void bench_enum(Bench &b, const char *strategy, const char *kind, size_t size)
+{
+    char case_[64];
+    snprintf(case_, sizeof(case_), "%s%zu", kind, size);
+
+    // look up random symbols
+    auto syms = esyms< E >();
+    C4_CHECK(syms.size() == size);
+    std::mt19937 rng(1234);
+    std::vector< E > values(NUM_LOOKUPS);
+    std::vector< const char* > names(NUM_LOOKUPS), shorts(NUM_LOOKUPS), out(NUM_LOOKUPS);
+    std::vector< std::string > misses(NUM_LOOKUPS);
+    for(size_t i = 0; i < NUM_LOOKUPS; ++i)
+    {
+        auto const& s = syms[rng() % size];
+        values[i] = s.value;
+        names[i] = s.name;
+        shorts[i] = s.name_offs(EOFFS_PFX);
+        misses[i] = s.name;
+        misses[i].back() = '#'; // no symbol has this spelling
+    }
+    const size_t mask = NUM_LOOKUPS - 1;
+    // names which are not symbols are not found, with any strategy
+    C4_CHECK(syms.find("") == nullptr && syms.find("", 0) == nullptr);
+    for(auto const& n : misses)
+        C4_CHECK(syms.find(n.data(), n.size()) == nullptr);
+
+    b.run("e2str", strategy, case_, NUM_LOOKUPS, 0, [&]{
+        for(E v : values)
+            do_not_optimize(e2str(v));
+    });
+    b.run("e2str.batch", strategy, case_, NUM_LOOKUPS, 0, [&]{
+        e2str(values.data(), values.size(), out.data());
+        do_not_optimize(out.data());
+    });
+    // each lookup depends on the result of the previous one
+    b.run("e2str.lat", strategy, case_, NUM_LOOKUPS, 0, [&]{
+        size_t j = 0;
+        for(size_t i = 0; i < NUM_LOOKUPS; ++i)
+        {
+            const char *s = e2str(values[j]);
+            j = (j + 1 + (s[0] & 1)) & mask;
+        }
+        do_not_optimize(j);
+    });
+    b.run("str2e", strategy, case_, NUM_LOOKUPS, 0, [&]{
+        for(const char *n : names)
+            do_not_optimize(str2e< E >(n));
+    });
+    b.run("str2e.short", strategy, case_, NUM_LOOKUPS, 0, [&]{
+        for(const char *n : shorts)
+            do_not_optimize(str2e< E >(n));
+    });
+    b.run("str2e.lat", strategy, case_, NUM_LOOKUPS, 0, [&]{
+        size_t j = 0;
+        for(size_t i = 0; i < NUM_LOOKUPS; ++i)
+        {
+            E v = str2e< E >(names[j]);
+            j = (j + 1 + (static_cast< size_t >(v) & 1)) & mask;
+        }
+        do_not_optimize(j);
+    });
+    b.run("str2e.miss", strategy, case_, NUM_LOOKUPS, 0, [&]{
+        for(auto const& n : misses)
+            do_not_optimize(syms.find(n.data(), n.size()));
+    });
+}
+
+//-----------------------------------------------------------------------------
+template< class E >
+void bench_bitmask(Bench &b, const char *strategy, size_t bits)
+{
+    using I = typename std::underlying_type< E >::type;
+    std::mt19937 rng(1234);
+    std::vector< size_t > positions(bits);
+    for(size_t i = 0; i < bits; ++i)
+        positions[i] = i;
+    for(size_t popcount : {1, 4, 8, 16, 32})
+    {
+        if(popcount > bits)
+            continue;
+        char case_[64];
+        snprintf(case_, sizeof(case_), "Flags%zu/pop%zu", bits, popcount);
+        std::vector< I > masks(NUM_MASKS);
+        std::vector< std::string > strs(NUM_MASKS);
+        std::vector< char > buf(1024);
+        for(size_t i = 0; i < NUM_MASKS; ++i)
+        {
+            std::shuffle(positions.begin(), positions.end(), rng);
+            I m = 0;
+            for(size_t j = 0; j < popcount; ++j)
+                m |= I(1) << positions[j];
+            masks[i] = m;
+            size_t len = bm2str< E >(m, buf.data(), buf.size());
+            C4_CHECK(len <= buf.size());
+            strs[i] = buf.data();
+            C4_CHECK(str2bm< E >(strs[i].c_str()) == m);
+        }
+        b.run("bm2str", strategy, case_, NUM_MASKS, 0, [&]{
+            for(I m : masks)
+                do_not_optimize(bm2str< E >(m, buf.data(), buf.size()));
+        });
+        std::vector< char > all(bm2str< E >(masks.data(), masks.size(), nullptr, 0, nullptr));
+        std::vector< size_t > offs(NUM_MASKS);
+        b.run("bm2str.batch", strategy, case_, NUM_MASKS, 0, [&]{
+            do_not_optimize(bm2str< E >(masks.data(), masks.size(), all.data(), all.size(), offs.data()));
+        });
+        b.run("str2bm", strategy, case_, NUM_MASKS, 0, [&]{
+            for(auto const& s : strs)
+                do_not_optimize(str2bm< E >(s.data(), s.size()));
+        });
+    }
+}
+
+//-----------------------------------------------------------------------------
+template< class Stream, class T >
+void bench_archive(Bench &b, const char *stream, const char *case_, std::vector< T > &data)
+{
+    std::vector< T > copy(data.size());
+    size_t num_bytes = data.size() * sizeof(T);
+    FILE *file = tmpfile();
+    C4_CHECK(file != nullptr);
+
+    auto write = [&]{
+        rewind(file);
+        c4::Archive< Stream > a;
+        a.write_mode(true, file);
+        a("data", data.data(), data.size());
+        a.flush();
+    };
+    auto read = [&]{
+        rewind(file);
+        c4::Archive< Stream > a;
+        a.write_mode(false, file);
+        a("data", copy.data(), copy.size());
+    };
+
+    // check the round trip first
+    write();
+    read();
+    C4_CHECK(memcmp(copy.data(), data.data(), num_bytes) == 0);
+
+    b.run("archive.write", stream, case_, data.size(), num_bytes, write);
+    b.run("archive.read", stream, case_, data.size(), num_bytes, read);
+
+    fclose(file);
+}
+
+/** write and read the particles column by column, and read only the
+ * column of x */
+template< class Stream >
+void bench_archive_columns(Bench &b, const char *stream, std::vector< Particle > &data)
+{
+    std::vector< Particle > copy(data.size());
+    std::vector< float > xs(data.size());
+    size_t num_bytes = data.size() * sizeof(Particle);
+    FILE *file = tmpfile();
+    C4_CHECK(file != nullptr);
+
+    auto write = [&]{
+        rewind(file);
+        c4::Archive< Stream > a;
+        a.write_mode(true, file);
+        a.columns("data", data.data(), data.size());
+        a.flush();
+    };
+    auto read = [&]{
+        rewind(file);
+        c4::Archive< Stream > a;
+        a.write_mode(false, file);
+        a.columns("data", copy.data(), copy.size());
+    };
+    auto read_x = [&]{
+        rewind(file);
+        c4::Archive< Stream > a;
+        a.write_mode(false, file);
+        a.template column< Particle >("data", "x", xs.data(), xs.size());
+    };
+
+    write();
+    read();
+    read_x();
+    C4_CHECK(memcmp(copy.data(), data.data(), num_bytes) == 0);
+    for(size_t i = 0; i < data.size(); ++i)
+        C4_CHECK(xs[i] == data[i].x);
+
+    b.run("archive.write", stream, "Particle.cols", data.size(), num_bytes, write);
+    b.run("archive.read", stream, "Particle.cols", data.size(), num_bytes, read);
+    b.run("archive.read", stream, "Particle.x", data.size(), xs.size() * sizeof(float), read_x);
+
+    fclose(file);
+}
+
+/** write and read the changes of the particles from a base archive,
+ * with one particle in a hundred changed */
+void bench_archive_delta(Bench &b, std::vector< Particle > &data)
+{
+    std::vector< Particle > changed(data), copy(data.size());
+    for(size_t i = 0; i < changed.size(); i += 100)
+        changed[i].vx += 1.f;
+    size_t num_bytes = data.size() * sizeof(Particle);
+    std::vector< char > base(num_bytes);
+    memcpy(base.data(), data.data(), num_bytes); // the plain binary format
+    FILE *file = tmpfile();
+    C4_CHECK(file != nullptr);
+
+    auto write = [&]{
+        rewind(file);
+        c4::Archive< c4::ArchiveStreamDelta > a;
+        a.write_mode(true, file, base.data(), base.size());
+        a("data", changed.data(), changed.size());
+        a.flush();
+    };
+    auto read = [&]{
+        rewind(file);
+        c4::Archive< c4::ArchiveStreamDelta > a;
+        a.write_mode(false, file, base.data(), base.size());
+        a("data", copy.data(), copy.size());
+    };
+
+    write();
+    read();
+    C4_CHECK(memcmp(copy.data(), changed.data(), num_bytes) == 0);
+
+    b.run("archive.write", "delta", "Particle", data.size(), num_bytes, write);
+    b.run("archive.read", "delta", "Particle", data.size(), num_bytes, read);
+
+    fclose(file);
+}
+
+/** read with a mapping of the file: with a copy, and (for NATIVE types)
+ * in place */
+template< class T >
+FILE* bench_archive_mapped(Bench &b, const char *case_, std::vector< T > &data)
+{
+    std::vector< T > copy(data.size());
+    size_t num_bytes = data.size() * sizeof(T);
+    FILE *file = tmpfile();
+    C4_CHECK(file != nullptr);
+    {
+        c4::Archive< c4::ArchiveStreamBinary > a;
+        a.write_mode(true, file);
+        a("data", data.data(), data.size());
+        a.flush();
+    }
+
+    auto read = [&]{
+        rewind(file);
+        c4::Archive< c4::ArchiveStreamMapped > a;
+        a.write_mode(false, file);
+        a("data", copy.data(), copy.size());
+    };
+    read();
+    C4_CHECK(memcmp(copy.data(), data.data(), num_bytes) == 0);
+    b.run("archive.read", "mapped", case_, data.size(), num_bytes, read);
+
+    return file;
+}
+
+template< class T >
+void bench_archive_view(Bench &b, const char *case_, std::vector< T > &data)
+{
+    FILE *file = bench_archive_mapped(b, case_, data);
+    size_t num_bytes = data.size() * sizeof(T);
+    std::vector< T > copy(data.size());
+    auto view = [&]{
+        rewind(file);
+        c4::Archive< c4::ArchiveStreamMapped > a;
+        a.write_mode(false, file);
+        do_not_optimize(a.view("data", copy.size(), copy.data()));
+    };
+    b.run("archive.view", "mapped", case_, data.size(), num_bytes, view);
+    fclose(file);
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, const char *argv[])
+{
+    Bench b;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--csv") == 0)
+            b.csv = true;
+        else if(strcmp(argv[i], "--min-time") == 0 && i+1 < argc)
+            b.min_time = atof(argv[++i]);
+        else
+            b.filter = argv[i];
+    }
+    b.header();
+
+#define _BENCH_ENUM(strategy, kind, size) \
+    bench_enum< strategy##_##kind##size >(b, #strategy, #kind, size);
+    BENCH_ENUMS(_BENCH_ENUM)
+#undef _BENCH_ENUM
+
+#define _BENCH_BITMASK(strategy, bits) \
+    bench_bitmask< strategy##_Flags##bits >(b, #strategy, bits);
+    BENCH_BITMASKS(_BENCH_BITMASK)
+#undef _BENCH_BITMASK
+
+    std::vector< int32_t > ints(NUM_PARTICLES);
+    std::vector< Particle > particles(NUM_PARTICLES);
+    for(size_t i = 0; i < NUM_PARTICLES; ++i)
+    {
+        ints[i] = int32_t(i * 7919);
+        float f = float(i);
+        particles[i] = Particle{f, f+1, f+2, -f, -f-1, -f-2, int32_t(i)};
+    }
+    bench_archive< c4::ArchiveStreamBinary >(b, "binary", "int32", ints);
+    bench_archive< c4::ArchiveStreamBinary >(b, "binary", "Particle", particles);
+    bench_archive< c4::ArchiveStreamBinaryBuffered >(b, "binbuf", "int32", ints);
+    bench_archive< c4::ArchiveStreamBinaryBuffered >(b, "binbuf", "Particle", particles);
+    bench_archive< c4::ArchiveStreamBinaryAsync >(b, "binasync", "int32", ints);
+    bench_archive< c4::ArchiveStreamBinaryAsync >(b, "binasync", "Particle", particles);
+    bench_archive_columns< c4::ArchiveStreamBinaryBuffered >(b, "binbuf", particles);
+    // in the byte order which is not the one of the host
+    using BinarySwapped = c4::ArchiveStreamBinaryEndian< c4::Endian_e::NATIVE == c4::Endian_e::LITTLE ? c4::Endian_e::BIG : c4::Endian_e::LITTLE >;
+    bench_archive< BinarySwapped >(b, "binswap", "int32", ints);
+    bench_archive< BinarySwapped >(b, "binswap", "Particle", particles);
+    bench_archive< c4::ArchiveStreamIndexed >(b, "indexed", "int32", ints);
+    bench_archive< c4::ArchiveStreamIndexed >(b, "indexed", "Particle", particles);
+    bench_archive_delta(b, particles);
+    bench_archive< c4::ArchiveStreamTagged >(b, "tagged", "int32", ints);
+    bench_archive< c4::ArchiveStreamTagged >(b, "tagged", "Particle", particles);
+    bench_archive< c4::ArchiveStreamVarint >(b, "varint", "int32", ints);
+    bench_archive< c4::ArchiveStreamVarint >(b, "varint", "Particle", particles);
+    bench_archive_view(b, "int32", ints);
+    fclose(bench_archive_mapped(b, "Particle", particles));
+    bench_archive< c4::ArchiveStreamText >(b, "text", "int32", ints);
+    bench_archive< c4::ArchiveStreamText >(b, "text", "Particle", particles);
+    bench_archive< c4::ArchiveStreamTextBuffered >(b, "txtbuf", "int32", ints);
+    bench_archive< c4::ArchiveStreamTextBuffered >(b, "txtbuf", "Particle", particles);
+    bench_archive_columns< c4::ArchiveStreamTextBuffered >(b, "txtbuf", particles);
+
+    return 0;
+}
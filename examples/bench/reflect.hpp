@@ -0,0 +1 @@
+../reflect/reflect.hpp
\ No newline at end of file
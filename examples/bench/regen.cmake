@@ -0,0 +1 @@
+../common/cmake/regen.cmake
\ No newline at end of file
@@ -0,0 +1,24 @@
+#!/usr/bin/env python3
+
+import os.path
+import sys
+import c4.regen as regen
+import inputs
+from serialize_gen import serialize  # see ../reflect/serialize_gen.py
+
+# ------------------------------------------------------------------------------
+
+def enum_generator(filename):
+    """the enums of each benchmark input file use the generator options
+    of the strategy of the file. @see inputs.py"""
+    strategy = inputs.strategy_of(filename) or 'phash'
+    return regen.EnumGenerator(**inputs.strategies[strategy])
+
+# ------------------------------------------------------------------------------
+
+writer = regen.ChunkWriterGenFile()
+
+# -----------------------------------------------------------------------------
+if __name__ == "__main__":
+    egen = enum_generator(os.path.basename(sys.argv[-1]))
+    regen.run(writer, egen, [serialize])
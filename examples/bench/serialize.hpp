@@ -0,0 +1 @@
+../reflect/serialize.hpp
\ No newline at end of file
@@ -0,0 +1 @@
+../reflect/serialize_gen.py
\ No newline at end of file
@@ -0,0 +1 @@
+../common/include/util.hpp
\ No newline at end of file
@@ -23,6 +23,8 @@ function(regen_setup wdir generated_headers generated_sources generated_targets)
     endif()
     message(STATUS "regen: checking dependencies...")
     set(REGEN_FILE ${wdir}/regen.py)
+    # the modules imported by regen.py, eg the shared templates
+    file(GLOB REGEN_MODULES ${wdir}/*.py)
     set(REGEN_EXEC python3 ${REGEN_FILE})
     set(REGEN_ARGS --clang-args "-std=c++11 -I ${wdir}")
     set(hdrs)
@@ -54,7 +56,7 @@ function(regen_setup wdir generated_headers generated_sources generated_targets)
             #message(STATUS "aqui 3 output_files=${output_files}")
             # add a custom command to run regen
             add_custom_command(OUTPUT ${output_files}
-                DEPENDS "${r}" "${REGEN_FILE}" "${CMAKE_CURRENT_LIST_FILE}"
+                DEPENDS "${r}" "${REGEN_FILE}" ${REGEN_MODULES} "${CMAKE_CURRENT_LIST_FILE}"
                 COMMAND ${REGEN_EXEC} --gen-code ${REGEN_ARGS} ${r}
                 COMMAND ${CMAKE_COMMAND} -E touch "${done_file}"
                 WORKING_DIRECTORY ${wdir}
@@ -66,8 +68,12 @@ function(regen_setup wdir generated_headers generated_sources generated_targets)
             add_custom_target(${r}-regen-target DEPENDS ${done_file})
             add_dependencies(regen ${r}-regen-target)
             # save the names
-            list(APPEND hdrs ${fghdr})
-            list(APPEND srcs ${fgsrc})
+            if(ghdr)
+                list(APPEND hdrs ${fghdr})
+            endif()
+            if(gsrc)
+                list(APPEND srcs ${fgsrc})
+            endif()
             list(APPEND tgts ${r}-regen-target)
         endif()
     endforeach()
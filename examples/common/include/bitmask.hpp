@@ -6,58 +6,172 @@
 
 #include "enum.hpp"
 
+namespace detail {
+
+/** count the trailing zeros of a nonzero integer */
+template< class U >
+inline unsigned bm_ctz(U v)
+{
+    C4_ASSERT(v != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(U) <= sizeof(unsigned) ?
+        (unsigned)__builtin_ctz((unsigned)v) :
+        (unsigned)__builtin_ctzll((unsigned long long)v);
+#else
+    unsigned n = 0;
+    for( ; !(v & 1); v >>= 1)
+        ++n;
+    return n;
+#endif
+}
+
+/** count the bits set in an integer */
+template< class U >
+inline unsigned bm_popcount(U v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(U) <= sizeof(unsigned) ?
+        (unsigned)__builtin_popcount((unsigned)v) :
+        (unsigned)__builtin_popcountll((unsigned long long)v);
+#else
+    unsigned n = 0;
+    for( ; v; v &= v - 1)
+        ++n;
+    return n;
+#endif
+}
+
+/** find the symbols making up a bitmask, giving preference to composite
+ * symbols. The indices of the symbols are written to matches (which must
+ * have room for one per bit), ordered by the lowest bit of each symbol.
+ *
+ * When regen generated the bitmask tables of the enum, the composites
+ * are tried by decreasing popcount, and then each remaining bit is
+ * looked up directly, so the cost depends on the number of bits set.
+ * Otherwise, all the symbols are scanned in reverse order, as composite
+ * symbols are likely to appear later in the enum sequence.
+ *
+ * @param bits the bitmask; on return, has the bits which were not found
+ * @return the number of symbols found */
+template< class E >
+size_t bm_decompose(EnumSymbols< E > const& syms,
+                    typename std::underlying_type< E >::type &bits,
+                    uint32_t *matches)
+{
+    using I = typename std::underlying_type< E >::type;
+    using U = typename std::make_unsigned< I >::type;
+    auto const* ix = syms.index();
+    auto const* s = syms.begin();
+    U ubits = static_cast< U >(bits);
+    // the matched symbols have no bits in common, so each is placed
+    // in the slot of its lowest bit. This sorts them for free.
+    U lowest = 0;
+    auto match = [&](uint32_t i, U b) {
+        unsigned l = bm_ctz(b);
+        matches[l] = i;
+        lowest |= U(1) << l;
+        ubits &= ~b;
+    };
+    if(ix && ix->bm_bits)
+    {
+        if(bm_popcount(ubits) > 1)
+        {
+            for(uint32_t k = 0; k < ix->bm_num_composites; ++k)
+            {
+                uint32_t i = ix->bm_composites[k];
+                U b = static_cast< U >(static_cast< I >(s[i].value));
+                if((ubits & b) == b)
+                    match(i, b);
+            }
+        }
+        for(U rest = ubits; rest; rest &= rest - 1)
+        {
+            unsigned b = bm_ctz(rest);
+            if(b >= ix->bm_num_bits)
+                break;
+            uint32_t i = ix->bm_bits[b];
+            if(i < syms.size())
+                match(i, U(1) << b);
+        }
+    }
+    else
+    {
+        for(size_t i = syms.size() - 1; i != size_t(-1); --i)
+        {
+            U b = static_cast< U >(static_cast< I >(s[i].value));
+            if((b != 0) && ((ubits & b) == b))
+                match(static_cast< uint32_t >(i), b);
+        }
+    }
+    // compact the slots
+    size_t num = 0;
+    for( ; lowest; lowest &= lowest - 1)
+        matches[num++] = matches[bm_ctz(lowest)];
+    bits = static_cast< I >(ubits);
+    return num;
+}
+
+/** whether a bitmask can be written with the generated per-byte tables:
+ * it must be nonzero, have only bits which have a symbol, and contain no
+ * composite symbol (which would be preferred to its bits) */
+template< class E >
+bool bm_lut_applies(EnumSymbols< E > const& syms, typename std::underlying_type< E >::type bits)
+{
+    using I = typename std::underlying_type< E >::type;
+    using U = typename std::make_unsigned< I >::type;
+    auto const* ix = syms.index();
+    U ubits = static_cast< U >(bits);
+    if( ! ix || ! ix->bm_lut_offs || ubits == 0 || (ubits & ~ix->bm_lut_mask))
+        return false;
+    if(bm_popcount(ubits) > 1)
+    {
+        for(uint32_t k = 0; k < ix->bm_num_composites; ++k)
+        {
+            U b = static_cast< U >(static_cast< I >(syms.begin()[ix->bm_composites[k]].value));
+            if((ubits & b) == b)
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+
 //-----------------------------------------------------------------------------
 /** write a bitmask to a stream, formatted as a string */
 template< class E, class Stream >
 Stream& bm2stream(typename std::underlying_type<E>::type bits, Stream &s)
 {
     using I = typename std::underlying_type<E>::type;
-    bool written = false;
-    for(auto const& p : esyms< E >())
+    auto syms = esyms< E >();
+    uint32_t matches[8 * sizeof(I)];
+    size_t num = detail::bm_decompose(syms, bits, matches);
+    for(size_t m = 0; m < num; ++m)
     {
-        I b(p.value);
-        if((b != 0) && ((bits & b) == b))
-        {
-            if(written) s << '|'; // append bit-or character
-            written = true;
-            s << p.name; // append bit string
-            bits &= ~b;
-        }
+        if(m > 0) s << '|'; // append bit-or character
+        s << syms.begin()[matches[m]].name; // append bit string
     }
-    if(!written)
+    if(num == 0)
     {
         s << 0;
     }
+    return s;
 }
 
 //-----------------------------------------------------------------------------
-/** convert a bitmask to string.
- * return the number of characters written. To find the needed size,
- * call first with str=nullptr and sz=0 */
+namespace detail {
+
+/** @see bm2str() */
 template< class E >
-size_t bm2str
-(
-    typename std::underlying_type<E>::type bits,
-    char *str = nullptr,
-    size_t sz = 0,
-    EnumOffsetType offst = EOFFS_PFX
-)
+size_t bm2str(EnumSymbols< E > const& syms, typename std::underlying_type<E>::type bits,
+              char *str, size_t sz, EnumOffsetType offst)
 {
     using I = typename std::underlying_type<E>::type;
+    using U = typename std::make_unsigned< I >::type;
     C4_ASSERT((str == nullptr) == (sz == 0));
 
-/** this macro simplifies the code
- * @todo improve this by writing from the end and moving only once. */
-#define _c4prependchars(code, num)                                      \
-    if(str && (pos + num <= sz))                                        \
-    {                                                                   \
-        /* move the current string to the right */                      \
-        memmove(str + num, str, pos);                                   \
-        /* now write in the beginning of the string */                  \
-        code;                                                           \
-    }                                                                   \
-    else if(str && sz) { C4_ERROR("cannot write to string pos=%d num=%d sz=%d", (int)pos, (int)num, (int)sz); } \
-    pos += num
+/** this macro simplifies the code */
 #define _c4appendchars(code, num)                                       \
     if(str && (pos + num <= sz))                                        \
     {                                                                   \
@@ -66,47 +180,62 @@ size_t bm2str
     else if(str && sz) { C4_ERROR("cannot write to string pos=%d num=%d sz=%d", (int)pos, (int)num, (int)sz); } \
     pos += num
 
-    auto syms = esyms< E >();
-
     size_t pos = 0;
-    typename EnumSymbols< E >::Sym const* zero = nullptr;
-    // do reverse iteration to give preference to composite enum symbols,
-    // which are likely to appear later in the enum sequence
-    for(size_t i = syms.size() - 1; i != size_t(-1); --i)
+
+    // masks of single bits can be written with one lookup per byte
+    if(offst == EOFFS_PFX && detail::bm_lut_applies(syms, bits))
     {
-        auto const p = syms[i];
-        I b = static_cast< I >(p.value);
-        if(b == 0)
+        auto const& ix = *syms.index();
+        U ubits = static_cast< U >(bits);
+        for(uint32_t k = 0; ubits; ++k, ubits >>= 8)
         {
-            zero = &p; // save this symbol for later
-        }
-        else if((bits & b) == b)
-        {
-            bits &= ~b;
-            // append bit-or character
+            uint32_t i = 256 * k + static_cast< uint32_t >(ubits & 0xff);
+            if( ! (ubits & 0xff))
+                continue;
+            C4_XASSERT(k < ix.bm_lut_num_bytes);
+            uint32_t o = ix.bm_lut_offs[i], len = ix.bm_lut_offs[i + 1] - o;
             if(pos > 0)
             {
-                _c4prependchars(*str = '|', 1);
+                _c4appendchars(str[pos] = '|', 1);
             }
-            // append bit string
-            const char *pname = p.name_offs(offst);
-            size_t len = strlen(pname);
-            _c4prependchars(strncpy(str, pname, len), len);
+            _c4appendchars(memcpy(str + pos, ix.bm_lut_names + o, len), len);
         }
+        _c4appendchars(str[pos] = '\0', 1);
+        return pos;
     }
 
+    // first find the matching symbols
+    uint32_t matches[8 * sizeof(I)];
+    size_t num_matches = detail::bm_decompose(syms, bits, matches);
     C4_CHECK_MSG(bits == 0, "could not find all bits");
+
+    // now write the matches in a single forward pass
+    for(size_t m = 0; m < num_matches; ++m)
+    {
+        auto const& p = syms.begin()[matches[m]];
+        // append bit-or character
+        if(pos > 0)
+        {
+            _c4appendchars(str[pos] = '|', 1);
+        }
+        // append bit string
+        const char *pname = p.name_offs(offst);
+        size_t len = p.name_len(offst);
+        _c4appendchars(memcpy(str + pos, pname, len), len);
+    }
+
     if(pos == 0) // make sure at least something is written
     {
+        auto const* zero = syms.find(static_cast< E >(0));
         if(zero) // if we have a zero symbol, use that
         {
             const char *pname = zero->name_offs(offst);
-            size_t len = strlen(pname);
-            _c4prependchars(strncpy(str, pname, len), len);
+            size_t len = zero->name_len(offst);
+            _c4appendchars(memcpy(str + pos, pname, len), len);
         }
         else // otherwise just write an integer zero
         {
-            _c4prependchars(*str = '0', 1);
+            _c4appendchars(str[pos] = '0', 1);
         }
     }
     _c4appendchars(str[pos] = '\0', 1);
@@ -115,7 +244,61 @@ size_t bm2str
 
 // cleanup!
 #undef _c4appendchars
-#undef _c4prependchars
+}
+
+} // namespace detail
+
+/** convert a bitmask to string.
+ * return the number of characters written. To find the needed size,
+ * call first with str=nullptr and sz=0. When regen generated the per-byte
+ * tables of the enum (bitmask='lut'), masks of single bits written with
+ * EOFFS_PFX take one lookup and one memcpy() per byte. */
+template< class E >
+size_t bm2str
+(
+    typename std::underlying_type<E>::type bits,
+    char *str = nullptr,
+    size_t sz = 0,
+    EnumOffsetType offst = EOFFS_PFX
+)
+{
+    return detail::bm2str(esyms< E >(), bits, str, sz, offst);
+}
+
+/** convert an array of bitmasks to strings, written one after the other,
+ * each terminated by '\0'. The string of bits[i] starts at str + offs[i]
+ * (offs may be null). Return the number of characters written. To find
+ * the needed size, call first with str=nullptr and sz=0. The symbol
+ * tables are resolved once for the whole array. */
+template< class E >
+size_t bm2str
+(
+    typename std::underlying_type<E>::type const* bits,
+    size_t num,
+    char *str,
+    size_t sz,
+    size_t *offs,
+    EnumOffsetType offst = EOFFS_PFX
+)
+{
+    C4_ASSERT((str == nullptr) == (sz == 0));
+    auto syms = esyms< E >();
+    size_t pos = 0;
+    for(size_t i = 0; i < num; ++i)
+    {
+        if(offs)
+            offs[i] = pos;
+        if(str)
+        {
+            C4_CHECK_MSG(pos < sz, "cannot write to string pos=%zu sz=%zu", pos, sz);
+            pos += detail::bm2str(syms, bits[i], str + pos, sz - pos, offst);
+        }
+        else
+        {
+            pos += detail::bm2str(syms, bits[i], nullptr, 0, offst);
+        }
+    }
+    return pos;
 }
 
 
@@ -146,71 +329,130 @@ bm2str
 
 //-----------------------------------------------------------------------------
 
-/** convert a string to a bitmask */
-template< class E >
-typename std::underlying_type<E>::type str2bm(const char *str, size_t sz)
+/** the result of parsing a bitmask string. @see str2bm() */
+typedef enum : uint8_t {
+    STR2BM_OK = 0,
+    STR2BM_EMPTY,           //< a term between '|' is empty
+    STR2BM_BAD_CHAR,        //< a character which cannot be in a bitmask string
+    STR2BM_BAD_NUMBER,      //< a malformed number, or too big for the type
+    STR2BM_UNKNOWN_NAME,    //< a name which is not a symbol of the enum
+} Str2BmError;
+
+namespace detail {
+
+inline bool bm_is_name_char(char c)
 {
-    using I = typename std::underlying_type<E>::type;
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+        || c == '_' || c == ':';
+}
 
-    I val = 0;
-    auto pairs = esyms< E >();
-    bool started = false;
-    bool alnum = false, num = false;
-    const char *f = nullptr;
-    size_t n = 0;
-    for(const char *c = str; c <= str + sz; ++c, ++n)
+/** parse a single term of a bitmask string, without surrounding spaces */
+template< class E >
+Str2BmError str2bm_term(EnumSymbols< E > const& syms, const char *s, size_t n,
+                        typename std::make_unsigned< typename std::underlying_type< E >::type >::type *v)
+{
+    using I = typename std::underlying_type< E >::type;
+    using U = typename std::make_unsigned< I >::type;
+    C4_ASSERT(n > 0);
+    if(*s >= '0' && *s <= '9')
     {
-        if((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || *c == '_')
-        {
-            C4_CHECK(!num);
-            if(!started)
-            {
-                f = c;
-                n = 0;
-                alnum = started = true;
-            }
-        }
-        else if(*c >= '0' && *c <= '9')
-        {
-            C4_CHECK(!alnum);
-            if(!started)
-            {
-                f = c;
-                n = 0;
-                num = started = true;
-            }
-        }
-        else if(*c == ':' || *c == ' ')
+        U base = 10, r = 0;
+        size_t i = 0;
+        if(n > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
         {
-            // skip this char
+            base = 16;
+            i = 2;
         }
-        else if(*c == '|' || *c == '\0')
+        for( ; i < n; ++i)
         {
-            C4_ASSERT(num != alnum);
-            if(num)
-            {
-                I tmp;
-                auto numconv = sscanf(f, detail::scanftag<I>::tag, &tmp);
-                C4_CHECK_MSG(numconv == 1, "could not read string as an int: '%.*s'", (int)n, f);
-                val |= tmp;
-            }
-            else if(alnum)
-            {
-                auto *p = pairs.find(f, n);
-                C4_CHECK_MSG(p != nullptr, "no valid enum pair name for '%.*s'", (int)n, f);
-                val |= static_cast< I >(p->value);
-            }
-            started = num = alnum = false;
-            if(*c == '\0')
-            {
-                break;
-            }
+            char c = s[i];
+            unsigned d;
+            if(c >= '0' && c <= '9')
+                d = unsigned(c - '0');
+            else if(base == 16 && c >= 'a' && c <= 'f')
+                d = unsigned(c - 'a' + 10);
+            else if(base == 16 && c >= 'A' && c <= 'F')
+                d = unsigned(c - 'A' + 10);
+            else
+                return bm_is_name_char(c) ? STR2BM_BAD_NUMBER : STR2BM_BAD_CHAR;
+            if(r > (U(-1) - d) / base)
+                return STR2BM_BAD_NUMBER;
+            r = r * base + d;
         }
-        else
+        *v = r;
+        return STR2BM_OK;
+    }
+    for(size_t i = 0; i < n; ++i)
+        if( ! bm_is_name_char(s[i]))
+            return STR2BM_BAD_CHAR;
+    auto const* p = syms.find(s, n);
+    if( ! p)
+        return STR2BM_UNKNOWN_NAME;
+    *v = static_cast< U >(static_cast< I >(p->value));
+    return STR2BM_OK;
+}
+
+} // namespace detail
+
+/** convert a string to a bitmask, reporting errors instead of aborting.
+ * The string has terms separated by '|', and spaces around the terms
+ * are ignored. Each term is either one of the spellings of a symbol
+ * accepted by EnumSymbols::find() (which uses the generated hash or
+ * trie, when there is one), or a decimal or 0x-prefixed hexadecimal
+ * integer. There are no allocations, and no calls to the stdio functions.
+ * @param str the string, which need not be null-terminated
+ * @param bits receives the bitmask. Not changed when there is an error.
+ * @param err_pos if not null, receives the position of the term with
+ *        the error */
+template< class E >
+Str2BmError str2bm(const char *str, size_t sz,
+                   typename std::underlying_type<E>::type *bits,
+                   size_t *err_pos = nullptr)
+{
+    using I = typename std::underlying_type<E>::type;
+    using U = typename std::make_unsigned< I >::type;
+
+    auto syms = esyms< E >();
+    U val = 0;
+    const char *c = str, *e = str + sz;
+    while(1)
+    {
+        const char *f = c;
+        while(c < e && *c != '|')
+            ++c;
+        const char *l = c;
+        while(f < l && *f == ' ')
+            ++f;
+        while(l > f && l[-1] == ' ')
+            --l;
+        U v = 0;
+        Str2BmError err = f < l ? detail::str2bm_term(syms, f, size_t(l - f), &v) : STR2BM_EMPTY;
+        if(err != STR2BM_OK)
         {
-            C4_ERROR("bad character '%c' in bitmask string", *c);
+            if(err_pos)
+                *err_pos = size_t(f - str);
+            return err;
         }
+        val |= v;
+        if(c == e)
+            break;
+        ++c; // skip the '|'
     }
+    *bits = static_cast< I >(val);
+    return STR2BM_OK;
+}
+
+/** convert a string to a bitmask. Errors are fatal. @see the overload
+ * returning Str2BmError. */
+template< class E >
+typename std::underlying_type<E>::type str2bm(const char *str, size_t sz)
+{
+    using I = typename std::underlying_type<E>::type;
+    I val = 0;
+    size_t pos = 0;
+    Str2BmError err = str2bm< E >(str, sz, &val, &pos);
+    C4_CHECK_MSG(err == STR2BM_OK, "could not parse bitmask string (error %d at %zu): '%.*s'",
+                 (int)err, pos, (int)sz, str);
     return val;
 }
 
@@ -2,8 +2,10 @@
 #define _C4_ENUM_HPP_
 
 #include "util.hpp"
+#include <array>
 #include <cstring>
 #include <iterator>
+#include <type_traits>
 
 typedef enum : uint8_t {
     EOFFS_NONE = 0,
@@ -12,35 +14,162 @@ typedef enum : uint8_t {
     _EOFFS_LAST      //< reserved
 } EnumOffsetType;
 
+//-----------------------------------------------------------------------------
+/** the final avalanche from murmur3 (fmix32).
+ * @warning must be kept in sync with emix() in c4/regen/enum_utils.py */
+inline uint32_t emix(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= UINT32_C(0x85ebca6b);
+    h ^= h >> 13;
+    h *= UINT32_C(0xc2b2ae35);
+    h ^= h >> 16;
+    return h;
+}
+
+/** hash a string for lookup in the generated perfect hash tables:
+ * 32 bit FNV-1a followed by emix().
+ * @warning must be kept in sync with ehash() in c4/regen/enum_utils.py */
+inline uint32_t ehash(const char *s, size_t len, uint32_t seed)
+{
+    uint32_t h = UINT32_C(2166136261) ^ seed;
+    for(size_t i = 0; i < len; ++i)
+    {
+        h ^= static_cast< uint8_t >(s[i]);
+        h *= UINT32_C(16777619);
+    }
+    return emix(h);
+}
+
 //-----------------------------------------------------------------------------
 /** A simple (proxy) container for the value-name pairs of an enum type.
- * Uses linear search for finds; this could be improved for time-critical
- * code. */
+ * Uses linear search for finds, unless an Index with lookup tables is
+ * provided (regen's built-in enum templates generate one). */
 template< class T >
 class EnumSymbols
 {
 public:
 
+    using I = typename std::underlying_type< T >::type;
+    using U = typename std::make_unsigned< I >::type;
+
+    /** a value-name pair. regen's built-in templates also store the name
+     * length and the class/prefix offsets, so that compares and formatting
+     * need no strlen() and no calls to eoffs(). When these are not given
+     * (ie, len=0), they are computed on the fly. */
     struct Sym
     {
         T value;
         const char *name;
+        uint8_t len;        //< strlen(name)
+        uint8_t offs_cls;   //< eoffs< T >(EOFFS_CLS)
+        uint8_t offs_pfx;   //< eoffs< T >(EOFFS_PFX)
 
         bool cmp(const char *s) const;
         bool cmp(const char *s, size_t len) const;
 
+        size_t name_len() const { return len ? len : strlen(name); }
+        size_t name_len(EnumOffsetType t) const { return name_len() - offs(t); }
+        size_t offs(EnumOffsetType t) const;
         const char *name_offs(EnumOffsetType t) const;
     };
 
+    /** a value-name pair with the name stored in a string pool shared by
+     * all the enums of a file, at pool + name_pos. This avoids a pointer
+     * (and its relocation) per symbol. @see unpool() */
+    struct PooledSym
+    {
+        T value;
+        uint32_t name_pos;
+        uint8_t len;
+        uint8_t offs_cls;
+        uint8_t offs_pfx;
+    };
+
+    /** a slot in the perfect hash table: the symbol, and the offset and
+     * length of the spelling hashed to this slot. Empty slots have len=0. */
+    struct NameSlot
+    {
+        uint32_t sym;
+        uint8_t offs;
+        uint8_t len;
+    };
+
+    /** optional lookup tables, generated by regen */
+    struct Index
+    {
+        /** name->symbol: a perfect hash of all the spellings accepted by
+         * Sym::cmp(). @see find(const char*, size_t) */
+        uint32_t hash_seed;
+        uint32_t hash_num_buckets;      //< must be a power of 2
+        uint32_t hash_num_slots;        //< must be a power of 2
+        uint32_t const* hash_disp;      //< one displacement per bucket
+        NameSlot const* hash_slots;
+
+        /** value->symbol. @see find(T)
+         * - when val_num > 0, the values are dense: the symbol of v is
+         *   val_syms[v - val_min]. Entries for missing values are >= the
+         *   number of symbols. When val_syms is null, the symbols are
+         *   declared in the order of their values and are indexed directly.
+         * - otherwise, val_syms (if not null) has the indices of all the
+         *   symbols sorted by value, and a binary search is done. */
+        I val_min;
+        uint32_t val_num;
+        uint32_t const* val_syms;
+
+        /** name->symbol: a generated function (eg a trie of switches)
+         * returning the index of the symbol with the given spelling, or
+         * a value >= the number of symbols when there is none. When this
+         * is given, the hash is not used. */
+        uint32_t (*name_find)(const char *s, size_t len);
+
+        /** bitmask->symbols, for enums which are bitmasks. @see bm2str()
+         * - bm_composites has the indices of the symbols with more than
+         *   one bit, by decreasing popcount.
+         * - bm_bits has, for each bit b < bm_num_bits, the index of the
+         *   symbol with value 1<<b, or a value >= the number of symbols
+         *   when there is none. Null when the enum is not a bitmask. */
+        uint32_t bm_num_composites;
+        uint32_t const* bm_composites;
+        uint32_t bm_num_bits;
+        uint32_t const* bm_bits;
+
+        /** bitmask->string, for masks of single bits. @see bm2str()
+         * For each byte k < bm_lut_num_bytes of a mask and each of its
+         * values v, the names (with EOFFS_PFX) of the bits set in v,
+         * joined by '|', are at bm_lut_names + bm_lut_offs[256*k+v],
+         * up to bm_lut_offs[256*k+v+1]. Only the bits in bm_lut_mask
+         * have a symbol, and the table of the last byte stops at the
+         * highest of these. Null when not generated. */
+        U bm_lut_mask;
+        uint32_t bm_lut_num_bytes;
+        uint32_t const* bm_lut_offs;
+        const char *bm_lut_names;
+    };
+
     using const_iterator = Sym const*;
     using const_reverse_iterator = std::reverse_iterator< Sym const* >;
 
 public:
 
     template< size_t N >
-    EnumSymbols(Sym const (&p)[N]) : m_symbols(p), m_num(N) {}
+    constexpr EnumSymbols(Sym const (&p)[N], Index const* idx = nullptr) : m_symbols(p), m_num(N), m_index(idx) {}
+
+    template< size_t N >
+    EnumSymbols(std::array< Sym, N > const& a, Index const* idx = nullptr) : m_symbols(a.data()), m_num(N), m_index(idx) {}
 
-    size_t size() const { return m_num; }
+    constexpr size_t size() const { return m_num; }
+    constexpr Index const* index() const { return m_index; }
+
+    /** get the symbols of pooled names, pointing into the pool */
+    template< size_t N >
+    static std::array< Sym, N > unpool(PooledSym const (&p)[N], const char *pool)
+    {
+        std::array< Sym, N > a;
+        for(size_t i = 0; i < N; ++i)
+            a[i] = Sym{p[i].value, pool + p[i].name_pos, p[i].len, p[i].offs_cls, p[i].offs_pfx};
+        return a;
+    }
 
     Sym const* get(T v) const { auto p = find(v); C4_CHECK_MSG(p != nullptr, "could not find symbol=%zd", (std::ptrdiff_t)v); return p; }
     Sym const* get(const char *s) const { auto p = find(s); C4_CHECK_MSG(p != nullptr, "could not find symbol \"%s\"", s); return p; }
@@ -50,6 +179,11 @@ public:
     Sym const* find(const char *s) const;
     Sym const* find(const char *s, size_t len) const;
 
+    /** find the symbols of an array of values: indices[i] receives the
+     * index of the symbol of vals[i], or a value >= size() when there is
+     * none. Returns true when all the values were found. */
+    bool find(T const* vals, size_t num, uint32_t *indices) const;
+
     Sym const& operator[] (size_t i) { C4_CHECK(i < m_num); return m_symbols[i]; }
 
     Sym const* begin() const { return m_symbols; }
@@ -62,6 +196,7 @@ private:
 
     Sym const* m_symbols;
     size_t const m_num;
+    Index const* m_index;
 
 };
 
@@ -73,6 +208,32 @@ private:
 template< class T >
 EnumSymbols< T > const esyms();
 
+/** holds the symbol tables of the enum type T as static constexpr data,
+ * so that esyms< T >() can be defined inline in a header, and calls like
+ * e2str(MyEnum::FOO) can be inlined and constant-folded by the compiler.
+ * regen's built-in templates specialize this when storage='constexpr'. */
+template< class T >
+struct esyms_data;
+
+
+/** the number of distinct values of the enum type T. With eindex() and
+ * evalue(), this maps the values of T to the dense range [0, esize()),
+ * in the order of the values, for containers indexed by enum.
+ * @see EnumSet, EnumArray
+ * @warning SPECIALIZE! regen's built-in templates specialize this and
+ * eindex()/evalue() for each enum type. */
+template< class T >
+constexpr size_t esize();
+
+/** get the dense index of an enum value, or esize< T >() when the
+ * value is not a symbol of T. @see esize() */
+template< class T >
+size_t eindex(T v);
+
+/** get the enum value with a dense index i < esize< T >(). @see esize() */
+template< class T >
+T evalue(size_t i);
+
 
 /** return the offset for an enum symbol class. For example,
  * eoffs_cls< MyEnumClass >() would be 13=strlen("MyEnumClass::").
@@ -148,35 +309,190 @@ const char* e2str(T e)
 template< class T >
 const char* e2stroffs(T e, EnumOffsetType ot = EOFFS_PFX)
 {
-    const char *s = e2str< T >(e) + eoffs< T >(ot);
-    return s;
+    auto es = esyms< T >();
+    auto *p = es.get(e);
+    return p->name_offs(ot);
+}
+
+/** get the c-strings corresponding to an array of enum values, with an
+ * offset: names[i] = e2stroffs(vals[i], ot). The symbol tables are
+ * resolved once for the whole array, and for dense enums the values are
+ * looked up without branches, so that the compiler can vectorize it. */
+template< class T >
+void e2str(T const* vals, size_t num, const char **names, EnumOffsetType ot = EOFFS_NONE)
+{
+    auto es = esyms< T >();
+    uint32_t indices[256];
+    for(size_t pos = 0; pos < num; pos += 256)
+    {
+        size_t n = num - pos < 256 ? num - pos : 256;
+        if( ! es.find(vals + pos, n, indices))
+            for(size_t i = 0; i < n; ++i)
+                es.get(vals[pos + i]); // fails on the first missing value
+        for(size_t i = 0; i < n; ++i)
+            names[pos + i] = es.begin()[indices[i]].name_offs(ot);
+    }
+}
+
+/** write the names of an array of enum values to a string, one after the
+ * other, each terminated by '\0'. The name of vals[i] starts at
+ * str + offs[i] (offs may be null). Return the number of characters
+ * written. To find the needed size, call first with str=nullptr and sz=0.
+ * @see e2str(T const*, size_t, const char**, EnumOffsetType) */
+template< class T >
+size_t e2str(T const* vals, size_t num, char *str, size_t sz, size_t *offs, EnumOffsetType ot = EOFFS_NONE)
+{
+    C4_ASSERT((str == nullptr) == (sz == 0));
+    auto es = esyms< T >();
+    uint32_t indices[256];
+    size_t len = 0;
+    for(size_t pos = 0; pos < num; pos += 256)
+    {
+        size_t n = num - pos < 256 ? num - pos : 256;
+        if( ! es.find(vals + pos, n, indices))
+            for(size_t i = 0; i < n; ++i)
+                es.get(vals[pos + i]); // fails on the first missing value
+        for(size_t i = 0; i < n; ++i)
+        {
+            auto const& p = es.begin()[indices[i]];
+            size_t nlen = p.name_len(ot);
+            if(offs)
+                offs[pos + i] = len;
+            if(str)
+            {
+                C4_CHECK_MSG(len + nlen + 1 <= sz, "cannot write to string pos=%zu num=%zu sz=%zu", len, nlen + 1, sz);
+                memcpy(str + len, p.name_offs(ot), nlen);
+                str[len + nlen] = '\0';
+            }
+            len += nlen + 1;
+        }
+    }
+    return len;
 }
 
 //-----------------------------------------------------------------------------
-/** Find a symbol by value. Returns nullptr when none is found */
+/** Find a symbol by value. Returns nullptr when none is found.
+ * When there is a value table, this is O(1) for dense enums and
+ * O(log N) for sparse enums. */
 template< class T >
 typename EnumSymbols< T >::Sym const* EnumSymbols< T >::find(T v) const
 {
+    if(m_index && m_index->val_num)
+    {
+        Index const& ix = *m_index;
+        U d = static_cast< U >(static_cast< I >(v)) - static_cast< U >(ix.val_min);
+        if(d >= ix.val_num)
+            return nullptr;
+        if( ! ix.val_syms)
+            return m_symbols + d;
+        uint32_t i = ix.val_syms[d];
+        return i < m_num ? m_symbols + i : nullptr;
+    }
+    else if(m_index && m_index->val_syms)
+    {
+        // binary search
+        uint32_t const* first = m_index->val_syms;
+        size_t count = m_num;
+        while(count > 0)
+        {
+            size_t half = count / 2;
+            if(static_cast< I >(m_symbols[first[half]].value) < static_cast< I >(v))
+            {
+                first += half + 1;
+                count -= half + 1;
+            }
+            else
+            {
+                count = half;
+            }
+        }
+        if(first < m_index->val_syms + m_num && m_symbols[*first].value == v)
+            return m_symbols + *first;
+        return nullptr;
+    }
     for(Sym const* p = this->m_symbols, *e = p+this->m_num; p < e; ++p)
         if(p->value == v)
             return p;
     return nullptr;
 }
 
+template< class T >
+bool EnumSymbols< T >::find(T const* vals, size_t num, uint32_t *indices) const
+{
+    uint32_t const nsyms = static_cast< uint32_t >(m_num);
+    if(m_index && m_index->val_num)
+    {
+        // dense values: no branches in the loops
+        Index const& ix = *m_index;
+        U const vmin = static_cast< U >(ix.val_min);
+        uint32_t missing = 0;
+        if( ! ix.val_syms)
+        {
+            for(size_t i = 0; i < num; ++i)
+            {
+                U d = static_cast< U >(static_cast< U >(static_cast< I >(vals[i])) - vmin);
+                uint32_t out = d >= ix.val_num;
+                indices[i] = out ? nsyms : static_cast< uint32_t >(d);
+                missing |= out;
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < num; ++i)
+            {
+                U d = static_cast< U >(static_cast< U >(static_cast< I >(vals[i])) - vmin);
+                uint32_t out = d >= ix.val_num;
+                uint32_t j = ix.val_syms[out ? 0 : d];
+                indices[i] = out ? nsyms : j;
+                missing |= (indices[i] >= nsyms);
+            }
+        }
+        return ! missing;
+    }
+    bool found = true;
+    for(size_t i = 0; i < num; ++i)
+    {
+        Sym const* p = find(vals[i]);
+        indices[i] = p ? static_cast< uint32_t >(p - m_symbols) : nsyms;
+        found = found && p;
+    }
+    return found;
+}
+
 /** Find a symbol by name. Returns nullptr when none is found */
 template< class T >
 typename EnumSymbols< T >::Sym const* EnumSymbols< T >::find(const char *s) const
 {
+    if(m_index && (m_index->name_find || m_index->hash_slots))
+        return find(s, strlen(s));
     for(Sym const* p = this->m_symbols, *e = p+this->m_num; p < e; ++p)
         if(p->cmp(s))
             return p;
     return nullptr;
 }
 
-/** Find a symbol by name. Returns nullptr when none is found */
+/** Find a symbol by name. Returns nullptr when none is found.
+ * When there is a perfect hash, this is O(1) with a single memcmp(). */
 template< class T >
 typename EnumSymbols< T >::Sym const* EnumSymbols< T >::find(const char *s, size_t len) const
 {
+    if(m_index && m_index->name_find)
+    {
+        uint32_t i = m_index->name_find(s, len);
+        return i < m_num ? m_symbols + i : nullptr;
+    }
+    else if(m_index && m_index->hash_slots)
+    {
+        Index const& ix = *m_index;
+        uint32_t h = ehash(s, len, ix.hash_seed);
+        uint32_t d = ix.hash_disp[h & (ix.hash_num_buckets - 1)];
+        NameSlot const& sl = ix.hash_slots[emix(h ^ d) & (ix.hash_num_slots - 1)];
+        if(sl.len != len || ! sl.len) // empty slots have no length
+            return nullptr;
+        C4_XASSERT(sl.sym < m_num);
+        Sym const* p = m_symbols + sl.sym;
+        return memcmp(p->name + sl.offs, s, len) == 0 ? p : nullptr;
+    }
     for(Sym const* p = this->m_symbols, *e = p+this->m_num; p < e; ++p)
         if(p->cmp(s, len))
             return p;
@@ -184,44 +500,31 @@ typename EnumSymbols< T >::Sym const* EnumSymbols< T >::find(const char *s, size
 }
 
 //-----------------------------------------------------------------------------
+/** compare against the full name, and against the name without the class
+ * and without the prefix */
 template< class T >
 bool EnumSymbols< T >::Sym::cmp(const char *s) const
 {
-    if(strcmp(name, s) == 0)
-        return true;
-
-    for(uint8_t i = 1; i < _EOFFS_LAST; ++i)
-    {
-        auto o = eoffs< T >((EnumOffsetType)i);
-        if(o > 0)
-            if(strcmp(name + o, s) == 0)
-                return true;
-    }
-
-    return false;
+    return cmp(s, strlen(s));
 }
 
 template< class T >
-bool EnumSymbols< T >::Sym::cmp(const char *s, size_t len) const
+bool EnumSymbols< T >::Sym::cmp(const char *s, size_t slen) const
 {
-    if(strncmp(name, s, len) == 0)
+    size_t nlen = name_len();
+    if(nlen == slen && memcmp(name, s, slen) == 0)
         return true;
 
-    size_t nlen = 0;
+    size_t prev = 0;
     for(uint8_t i = 1; i < _EOFFS_LAST; ++i)
     {
-        auto o = eoffs< T >((EnumOffsetType)i);
-        if(o > 0)
+        size_t o = offs((EnumOffsetType)i);
+        if(o > prev)
         {
-            if(!nlen)
-            {
-                nlen = strlen(name);
-            }
             C4_ASSERT(o < nlen);
-            size_t rem = nlen - o;
-            auto m = len > rem ? len : rem;
-            if(len >= m && strncmp(name + o, s, m) == 0)
+            if(nlen - o == slen && memcmp(name + o, s, slen) == 0)
                 return true;
+            prev = o;
         }
     }
 
@@ -229,11 +532,31 @@ bool EnumSymbols< T >::Sym::cmp(const char *s, size_t len) const
 }
 
 //-----------------------------------------------------------------------------
+template< class T >
+size_t EnumSymbols< T >::Sym::offs(EnumOffsetType t) const
+{
+    if( ! len)
+        return eoffs< T >(t);
+    switch(t)
+    {
+    case EOFFS_NONE:
+        return 0;
+    case EOFFS_CLS:
+        return offs_cls;
+    case EOFFS_PFX:
+        return offs_pfx;
+    default:
+        C4_ERROR("unknown offset type %d", (int)t);
+        return 0;
+    }
+}
+
 template< class T >
 const char* EnumSymbols< T >::Sym::name_offs(EnumOffsetType t) const
 {
-    C4_ASSERT(eoffs< T >(t) < strlen(name));
-    return name + eoffs< T >(t);
+    size_t o = offs(t);
+    C4_ASSERT(o < name_len());
+    return name + o;
 }
 
 #endif // _C4_ENUM_HPP_
@@ -0,0 +1,212 @@
+#ifndef _C4_ENUM_CONTAINERS_HPP_
+#define _C4_ENUM_CONTAINERS_HPP_
+
+#include <array>
+#include <initializer_list>
+#include <iterator>
+
+#include "bitmask.hpp"
+
+//-----------------------------------------------------------------------------
+/** A set of values of the enum type E, stored as a fixed-size bitset with
+ * one bit per value: bit eindex< E >(v) is set when v is in the set.
+ * Unions and intersections are done a word at a time over arrays of
+ * fixed size, so the compiler can unroll and vectorize them. Iteration
+ * walks the bits set with ctz, in the order of the values.
+ * @see esize(), eindex(), evalue() */
+template< class E >
+class EnumSet
+{
+public:
+
+    using word_type = uint64_t;
+
+    enum : size_t {
+        num_values = esize< E >(),
+        bits_per_word = 8 * sizeof(word_type),
+        num_words = num_values > 0 ? (num_values + bits_per_word - 1) / bits_per_word : 1,
+    };
+
+    class const_iterator
+    {
+    public:
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = E const*;
+        using reference = E;
+
+        const_iterator(word_type const* words, size_t w) : m_words(words), m_word(w), m_bits(0)
+        {
+            for( ; m_word < num_words && ! (m_bits = m_words[m_word]); ++m_word)
+                ;
+        }
+
+        E operator* () const
+        {
+            C4_XASSERT(m_bits != 0);
+            return evalue< E >(bits_per_word * m_word + detail::bm_ctz(m_bits));
+        }
+
+        const_iterator& operator++ ()
+        {
+            m_bits &= m_bits - 1;
+            while( ! m_bits && ++m_word < num_words)
+                m_bits = m_words[m_word];
+            return *this;
+        }
+        const_iterator operator++ (int) { const_iterator tmp = *this; ++*this; return tmp; }
+
+        bool operator== (const_iterator const& that) const { return m_word == that.m_word && m_bits == that.m_bits; }
+        bool operator!= (const_iterator const& that) const { return ! (*this == that); }
+
+    private:
+
+        word_type const* m_words;
+        size_t m_word;
+        word_type m_bits;
+    };
+
+public:
+
+    EnumSet() : m_words() {}
+    EnumSet(std::initializer_list< E > il) : m_words()
+    {
+        for(E v : il)
+            insert(v);
+    }
+
+    /** the set with all the values of E */
+    static EnumSet all()
+    {
+        EnumSet s;
+        for(size_t w = 0; w < num_words; ++w)
+            s.m_words[w] = ~word_type(0);
+        if(num_values % bits_per_word)
+            s.m_words[num_words - 1] = (word_type(1) << (num_values % bits_per_word)) - 1;
+        else if(num_values == 0)
+            s.m_words[0] = 0;
+        return s;
+    }
+
+    bool contains(E v) const
+    {
+        size_t i = eindex< E >(v);
+        return i < num_values && (m_words[i / bits_per_word] >> (i % bits_per_word)) & 1;
+    }
+    size_t count(E v) const { return contains(v) ? 1 : 0; }
+
+    void insert(E v)
+    {
+        size_t i = eindex< E >(v);
+        C4_CHECK_MSG(i < num_values, "not a symbol: %zd", (std::ptrdiff_t)v);
+        m_words[i / bits_per_word] |= word_type(1) << (i % bits_per_word);
+    }
+    void erase(E v)
+    {
+        size_t i = eindex< E >(v);
+        if(i < num_values)
+            m_words[i / bits_per_word] &= ~(word_type(1) << (i % bits_per_word));
+    }
+    void clear()
+    {
+        for(size_t w = 0; w < num_words; ++w)
+            m_words[w] = 0;
+    }
+
+    size_t size() const
+    {
+        size_t n = 0;
+        for(size_t w = 0; w < num_words; ++w)
+            n += detail::bm_popcount(m_words[w]);
+        return n;
+    }
+    bool empty() const
+    {
+        word_type any = 0;
+        for(size_t w = 0; w < num_words; ++w)
+            any |= m_words[w];
+        return ! any;
+    }
+
+    const_iterator begin() const { return const_iterator(m_words, 0); }
+    const_iterator end  () const { return const_iterator(m_words, num_words); }
+
+    word_type const* words() const { return m_words; }
+
+    EnumSet& operator|= (EnumSet const& that) { for(size_t w = 0; w < num_words; ++w) m_words[w] |= that.m_words[w]; return *this; }
+    EnumSet& operator&= (EnumSet const& that) { for(size_t w = 0; w < num_words; ++w) m_words[w] &= that.m_words[w]; return *this; }
+    EnumSet& operator^= (EnumSet const& that) { for(size_t w = 0; w < num_words; ++w) m_words[w] ^= that.m_words[w]; return *this; }
+    EnumSet& operator-= (EnumSet const& that) { for(size_t w = 0; w < num_words; ++w) m_words[w] &= ~that.m_words[w]; return *this; }
+
+    friend EnumSet operator| (EnumSet a, EnumSet const& b) { return a |= b; }
+    friend EnumSet operator& (EnumSet a, EnumSet const& b) { return a &= b; }
+    friend EnumSet operator^ (EnumSet a, EnumSet const& b) { return a ^= b; }
+    friend EnumSet operator- (EnumSet a, EnumSet const& b) { return a -= b; }
+
+    bool operator== (EnumSet const& that) const
+    {
+        word_type diff = 0;
+        for(size_t w = 0; w < num_words; ++w)
+            diff |= m_words[w] ^ that.m_words[w];
+        return ! diff;
+    }
+    bool operator!= (EnumSet const& that) const { return ! (*this == that); }
+
+private:
+
+    word_type m_words[num_words];
+
+};
+
+
+//-----------------------------------------------------------------------------
+/** A flat array with a value of type V for each value of the enum type
+ * E, indexed by eindex< E >(). A replacement for std::map< E, V > when
+ * all the values of E are used, with no allocations and no nodes.
+ * @see esize(), eindex(), evalue() */
+template< class E, class V >
+class EnumArray
+{
+public:
+
+    using value_type = V;
+    using iterator = V*;
+    using const_iterator = V const*;
+
+    enum : size_t { num_values = esize< E >() };
+
+public:
+
+    EnumArray() : m_vals() {}
+    explicit EnumArray(V const& v) { fill(v); }
+
+    /** the enum value of the i-th element */
+    static E key(size_t i) { return evalue< E >(i); }
+
+    V      & operator[] (E e)       { size_t i = eindex< E >(e); C4_XASSERT(i < num_values); return m_vals[i]; }
+    V const& operator[] (E e) const { size_t i = eindex< E >(e); C4_XASSERT(i < num_values); return m_vals[i]; }
+
+    V      & at(E e)       { size_t i = eindex< E >(e); C4_CHECK_MSG(i < num_values, "not a symbol: %zd", (std::ptrdiff_t)e); return m_vals[i]; }
+    V const& at(E e) const { size_t i = eindex< E >(e); C4_CHECK_MSG(i < num_values, "not a symbol: %zd", (std::ptrdiff_t)e); return m_vals[i]; }
+
+    void fill(V const& v) { m_vals.fill(v); }
+
+    constexpr size_t size() const { return num_values; }
+
+    V      * data()       { return m_vals.data(); }
+    V const* data() const { return m_vals.data(); }
+
+    iterator       begin()       { return m_vals.data(); }
+    iterator       end  ()       { return m_vals.data() + num_values; }
+    const_iterator begin() const { return m_vals.data(); }
+    const_iterator end  () const { return m_vals.data() + num_values; }
+
+private:
+
+    std::array< V, num_values > m_vals;
+
+};
+
+#endif // _C4_ENUM_CONTAINERS_HPP_
@@ -3,6 +3,7 @@
 
 #include "myenum.hpp"
 #include "bitmask.hpp"
+#include "enum_containers.hpp"
 
 // a googletest stub
 #define _EXPECT_EQ(expr1, expr2, cmp)                            \
@@ -39,7 +40,37 @@ void test_e2str()
         EXPECT_EQ((I)str2e< E >(e2str(p.value)), (I)p.value);
         // test the other way around
         EXPECT_STR_EQ(e2str(str2e< E >(p.name)), p.name);
+        // the precomputed lengths and offsets must be consistent
+        EXPECT_EQ(p.name_len(), strlen(p.name));
+        EXPECT_EQ(p.offs(EOFFS_CLS), eoffs< E >(EOFFS_CLS));
+        EXPECT_EQ(p.offs(EOFFS_PFX), eoffs< E >(EOFFS_PFX));
     }
+
+    // names which are not symbols are never found, whichever the lookup
+    // (str2e() aborts on these)
+    std::string unknown = std::string(esyms< E >().begin()[0].name) + "_NOT_A_SYMBOL";
+    EXPECT_EQ((esyms< E >().find("") == nullptr), true);
+    EXPECT_EQ((esyms< E >().find("", 0) == nullptr), true);
+    EXPECT_EQ((esyms< E >().find(unknown.data(), 0) == nullptr), true);
+    EXPECT_EQ((esyms< E >().find(unknown.c_str()) == nullptr), true);
+    EXPECT_EQ((esyms< E >().find(unknown.data(), unknown.size()) == nullptr), true);
+
+    // the batch versions must match the single-value versions. Use more
+    // values than the size of the batches.
+    auto syms = esyms< E >();
+    std::vector< E > vals(600);
+    for(size_t i = 0; i < vals.size(); ++i)
+        vals[i] = syms.begin()[(i * 7) % syms.size()].value;
+    std::vector< const char* > names(vals.size());
+    e2str(vals.data(), vals.size(), names.data(), EOFFS_PFX);
+    for(size_t i = 0; i < vals.size(); ++i)
+        EXPECT_STR_EQ(names[i], e2stroffs(vals[i], EOFFS_PFX));
+    size_t len = e2str(vals.data(), vals.size(), nullptr, 0, nullptr);
+    std::vector< char > buf(len);
+    std::vector< size_t > offs(vals.size());
+    EXPECT_EQ(e2str(vals.data(), vals.size(), buf.data(), buf.size(), offs.data()), len);
+    for(size_t i = 0; i < vals.size(); ++i)
+        EXPECT_STR_EQ(&buf[offs[i]], e2str(vals[i]));
 }
 
 template< typename E >
@@ -50,6 +81,7 @@ void test_bm2str()
     auto syms = esyms< E >();
 
     std::vector< int > indices;
+    std::vector< I > vals;
     std::string str;
     std::vector< char > ws;
     I val = 0, res;
@@ -77,17 +109,20 @@ void test_bm2str()
 
             res = str2bm< E >(str.data());
             EXPECT_EQ(res, val);
+            vals.push_back(val);
 
             len = bm2str< E >(res); // needed length
             ws.resize(len);
-            bm2str< E >(val, &ws[0], len);
+            EXPECT_EQ(bm2str< E >(val, &ws[0], len), len);
+            EXPECT_EQ(strlen(ws.data()) + 1, len);
             res = str2bm< E >(ws.data());
             EXPECT_EQ(res, val);
 
             // write a string with the bitmask as an int
+            ws.resize(32);
             int ret = snprintf(&ws[0], ws.size(), "%" PRId64, (int64_t)val);
             C4_CHECK((size_t)ret < ws.size());
-            res = str2bm< E >(str.data());
+            res = str2bm< E >(ws.data());
             EXPECT_EQ(res, val);
 
             bool carry = true;
@@ -110,4 +145,114 @@ void test_bm2str()
             }
         } // while(1)
     } // for k
+
+    // the batch version must match the single-value version
+    std::vector< size_t > offs(vals.size());
+    len = bm2str< E >(vals.data(), vals.size(), nullptr, 0, nullptr);
+    ws.resize(len);
+    EXPECT_EQ(bm2str< E >(vals.data(), vals.size(), &ws[0], len, offs.data()), len);
+    std::vector< char > one;
+    for(size_t i = 0; i < vals.size(); ++i)
+    {
+        one.resize(bm2str< E >(vals[i]));
+        bm2str< E >(vals[i], &one[0], one.size());
+        EXPECT_STR_EQ(&ws[offs[i]], one.data());
+    }
+}
+
+template< typename E >
+void test_str2bm()
+{
+    using I = typename std::underlying_type< E >::type;
+    auto syms = esyms< E >();
+    std::string a = syms.begin()[0].name, b = syms.begin()[1].name;
+    I ab = static_cast< I >(syms.begin()[0].value) | static_cast< I >(syms.begin()[1].value);
+    I res = 0;
+    size_t pos = 0;
+
+    auto parse = [&](std::string const& s) {
+        res = 0;
+        pos = size_t(-1);
+        return (int)str2bm< E >(s.data(), s.size(), &res, &pos);
+    };
+
+    EXPECT_EQ(parse(a + "|" + b), (int)STR2BM_OK);
+    EXPECT_EQ(res, ab);
+    EXPECT_EQ(parse("  " + a + " |  " + b + " "), (int)STR2BM_OK);
+    EXPECT_EQ(res, ab);
+    EXPECT_EQ(parse(a + "|12|0x10"), (int)STR2BM_OK);
+    EXPECT_EQ(res, (static_cast< I >(syms.begin()[0].value) | 12 | 16));
+    // the string does not need to be null-terminated
+    EXPECT_EQ((int)str2bm< E >((a + "|" + b).data(), a.size(), &res), (int)STR2BM_OK);
+    EXPECT_EQ(res, static_cast< I >(syms.begin()[0].value));
+
+    // errors: the result is not changed
+    EXPECT_EQ(parse(""), (int)STR2BM_EMPTY);
+    EXPECT_EQ(res, 0);
+    EXPECT_EQ(parse(a + "||" + b), (int)STR2BM_EMPTY);
+    EXPECT_EQ(pos, a.size() + 1);
+    EXPECT_EQ(parse(a + "| "), (int)STR2BM_EMPTY);
+    EXPECT_EQ(parse(a + "|" + b + "#"), (int)STR2BM_BAD_CHAR);
+    EXPECT_EQ(pos, a.size() + 1);
+    EXPECT_EQ(parse(a + "|1-2"), (int)STR2BM_BAD_CHAR);
+    EXPECT_EQ(parse("12a"), (int)STR2BM_BAD_NUMBER);
+    EXPECT_EQ(parse("0x"), (int)STR2BM_BAD_NUMBER);
+    EXPECT_EQ(parse("0x1000000000000000000"), (int)STR2BM_BAD_NUMBER);
+    EXPECT_EQ(parse("99999999999999999999999"), (int)STR2BM_BAD_NUMBER);
+    EXPECT_EQ(parse(a + "|" + a + "_NOT_A_SYMBOL"), (int)STR2BM_UNKNOWN_NAME);
+    EXPECT_EQ(pos, a.size() + 1);
+    EXPECT_EQ(res, 0);
+}
+
+template< typename E >
+void test_enum_containers()
+{
+    using I = typename std::underlying_type< E >::type;
+    auto syms = esyms< E >();
+    size_t num = esize< E >();
+
+    // the dense indices follow the order of the values
+    for(auto &p : syms)
+    {
+        size_t i = eindex(p.value);
+        EXPECT_EQ((i < num), true);
+        EXPECT_EQ((I)evalue< E >(i), (I)p.value);
+    }
+    for(size_t i = 1; i < num; ++i)
+        EXPECT_EQ(((I)evalue< E >(i - 1) < (I)evalue< E >(i)), true);
+
+    EnumSet< E > s, all = EnumSet< E >::all();
+    EXPECT_EQ(s.empty(), true);
+    EXPECT_EQ(s.size(), 0);
+    EXPECT_EQ(all.size(), num);
+    size_t n = 0;
+    for(E v : all)
+        EXPECT_EQ((I)v, (I)evalue< E >(n++));
+    EXPECT_EQ(n, num);
+
+    E first = evalue< E >(0), last = evalue< E >(num - 1);
+    s.insert(last);
+    s.insert(first);
+    s.insert(first);
+    EXPECT_EQ(s.size(), 2);
+    EXPECT_EQ(s.contains(first), true);
+    EXPECT_EQ(s.contains(evalue< E >(1)), false);
+    EXPECT_EQ((I)*s.begin(), (I)first);
+    EXPECT_EQ(((s | all) == all), true);
+    EXPECT_EQ(((s & all) == s), true);
+    EXPECT_EQ((all - s).size(), num - 2);
+    EXPECT_EQ((all - s).contains(first), false);
+    EXPECT_EQ(((all ^ s) == (all - s)), true);
+    s.erase(first);
+    EXPECT_EQ(s.size(), 1);
+    EXPECT_EQ(((s == EnumSet< E >{last}) && (s != all)), true);
+    s.clear();
+    EXPECT_EQ(s.empty(), true);
+
+    EnumArray< E, int > a(-1);
+    EXPECT_EQ(a.size(), num);
+    for(auto &p : syms)
+        a[p.value] = (int)eindex(p.value);
+    for(size_t i = 0; i < num; ++i)
+        EXPECT_EQ(a.at(EnumArray< E, int >::key(i)), (int)i);
 }
@@ -24,6 +24,16 @@ int main(int argc, const char* argv[])
     EXPECT_BM_EQ(esyms< MyEnumClass >().get("MyEnumClass::FOO")->value, MyEnumClass::FOO);
     EXPECT_BM_EQ(esyms< MyEnumClass >().get("FOO")->value, MyEnumClass::FOO);
 
+    // only exact spellings are accepted
+    EXPECT_EQ((esyms< MyEnumClass >().find("MyEnumClass::QUX") == nullptr), true);
+    EXPECT_EQ((esyms< MyEnumClass >().find("FOOO") == nullptr), true);
+    EXPECT_EQ((esyms< MyEnumClass >().find("FOO", 2) == nullptr), true);
+    EXPECT_EQ((esyms< MyEnumClass >().find("MyEnumClass::", 13) == nullptr), true);
+    EXPECT_BM_EQ(esyms< MyEnumClass >().find("BARBAZ", 3)->value, MyEnumClass::BAR);
+    EXPECT_EQ(esyms< MyEnumClass >().get(MyEnumClass::FOO)->cmp("FOO"), true);
+    EXPECT_EQ(esyms< MyEnumClass >().get(MyEnumClass::FOO)->cmp("FOO", 2), false);
+    EXPECT_EQ(esyms< MyEnumClass >().get(MyEnumClass::FOO)->cmp("MyEnumClass::FOOO", 16), true);
+
     EXPECT_BM_EQ(esyms< MyBitmask >().get("BM_FOO")->value, MyBitmask::BM_FOO);
     EXPECT_BM_EQ(esyms< MyBitmask >().get("FOO")->value, MyBitmask::BM_FOO);
     EXPECT_BM_EQ(str2bm< MyBitmask >("BM_FOO|BM_BAR"), BM_FOO_BAR);
@@ -52,6 +62,14 @@ int main(int argc, const char* argv[])
     EXPECT_STR_EQ(ws_cls.data(), "BM_FOO|BM_BAZ");
     EXPECT_STR_EQ(ws_pfx.data(), "FOO|BAZ");
     EXPECT_STR_EQ(ws_default.data(), "FOO|BAZ");
+    // composites are preferred
+    EXPECT_EQ(bm2str< MyBitmask >(BM_BAZ|BM_BAR|BM_FOO), strlen("FOO_BAR_BAZ") + 1);
+    bm2str< MyBitmask >(BM_BAZ|BM_BAR|BM_FOO, &ws_pfx[0], ws_pfx.size(), EOFFS_PFX);
+    EXPECT_STR_EQ(ws_pfx.data(), "FOO_BAR_BAZ");
+    bm2str< MyBitmask >(BM_BAZ|BM_FOO_BAR, &ws_pfx[0], ws_pfx.size(), EOFFS_PFX);
+    EXPECT_STR_EQ(ws_pfx.data(), "FOO_BAR_BAZ");
+    bm2str< MyBitmask >(BM_NONE, &ws_pfx[0], ws_pfx.size(), EOFFS_PFX);
+    EXPECT_STR_EQ(ws_pfx.data(), "NONE");
 
     bm2str< MyBitmaskClass >(MyBitmaskClass::BM_FOO_BAR, &ws_all[0], ws_all.size(), EOFFS_NONE);
     bm2str< MyBitmaskClass >(MyBitmaskClass::BM_FOO_BAR, &ws_cls[0], ws_cls.size(), EOFFS_CLS);
@@ -73,9 +91,28 @@ int main(int argc, const char* argv[])
 
     test_e2str< MyEnumClass >();
     test_e2str< MyEnum >();
+    test_e2str< MySparseEnum >();
+
+    EXPECT_STR_EQ(e2str(SP_FOO), "SP_FOO");
+    EXPECT_STR_EQ(e2str(SP_BAZ), "SP_BAZ");
+    EXPECT_EQ((esyms< MySparseEnum >().find((MySparseEnum)0) == nullptr), true);
+    EXPECT_EQ((esyms< MySparseEnum >().find((MySparseEnum)2000) == nullptr), true);
+    EXPECT_EQ((esyms< MyBitmask >().find((MyBitmask)5) == nullptr), true);
+    EXPECT_EQ((esyms< MyBitmask >().find((MyBitmask)8) == nullptr), true);
+    EXPECT_STR_EQ(e2str(BM_FOO_BAR), "BM_FOO_BAR");
 
     test_bm2str< MyBitmask >();
     test_bm2str< MyBitmaskClass >();
+    test_str2bm< MyBitmask >();
+    test_str2bm< MyBitmaskClass >();
+
+    test_enum_containers< MyEnum >();
+    test_enum_containers< MyEnumClass >();
+    test_enum_containers< MySparseEnum >();
+    test_enum_containers< MyBitmask >();
+    test_enum_containers< MyBitmaskClass >();
+    EXPECT_EQ(eindex((MySparseEnum)0), esize< MySparseEnum >());
+    EXPECT_EQ(eindex((MyBitmask)5), esize< MyBitmask >());
 
     return error_status;
 }
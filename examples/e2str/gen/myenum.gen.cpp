@@ -3,52 +3,51 @@
 #include "myenum.gen.hpp"
 
 /** enum: auto-generated from myenum.hpp:7: C4_ENUM: MyEnum */
-template<> const EnumSymbols< MyEnum > esyms()
-{
-    static const EnumSymbols< MyEnum >::Sym vals[] = {
-        { FOO, "FOO"},
-        { BAR, "BAR"},
-        { BAZ, "BAZ"},
-    };
-    EnumSymbols< MyEnum > r(vals);
-    return r;
-}
+
+#if __cplusplus < 201703L // C++17 static constexpr members are inline
+constexpr EnumSymbols< MyEnum >::Sym esyms_data< MyEnum >::vals[];
+constexpr uint32_t esyms_data< MyEnum >::hash_disp[];
+constexpr EnumSymbols< MyEnum >::NameSlot esyms_data< MyEnum >::hash_slots[];
+constexpr uint32_t esyms_data< MyEnum >::bm_bits[];
+constexpr EnumSymbols< MyEnum >::Index esyms_data< MyEnum >::idx;
+#endif
 /** enum: auto-generated from myenum.hpp:14: C4_ENUM: MyEnumClass */
-template<> const EnumSymbols< MyEnumClass > esyms()
-{
-    static const EnumSymbols< MyEnumClass >::Sym vals[] = {
-        { MyEnumClass::FOO, "MyEnumClass::FOO"},
-        { MyEnumClass::BAR, "MyEnumClass::BAR"},
-        { MyEnumClass::BAZ, "MyEnumClass::BAZ"},
-    };
-    EnumSymbols< MyEnumClass > r(vals);
-    return r;
-}
-/** enum: auto-generated from myenum.hpp:21: C4_ENUM: MyBitmask */
-template<> const EnumSymbols< MyBitmask > esyms()
-{
-    static const EnumSymbols< MyBitmask >::Sym vals[] = {
-        { BM_NONE, "BM_NONE"},
-        { BM_FOO, "BM_FOO"},
-        { BM_BAR, "BM_BAR"},
-        { BM_BAZ, "BM_BAZ"},
-        { BM_FOO_BAR, "BM_FOO_BAR"},
-        { BM_FOO_BAR_BAZ, "BM_FOO_BAR_BAZ"},
-    };
-    EnumSymbols< MyBitmask > r(vals);
-    return r;
-}
-/** enum: auto-generated from myenum.hpp:31: C4_ENUM: MyBitmaskClass */
-template<> const EnumSymbols< MyBitmaskClass > esyms()
-{
-    static const EnumSymbols< MyBitmaskClass >::Sym vals[] = {
-        { MyBitmaskClass::BM_NONE, "MyBitmaskClass::BM_NONE"},
-        { MyBitmaskClass::BM_FOO, "MyBitmaskClass::BM_FOO"},
-        { MyBitmaskClass::BM_BAR, "MyBitmaskClass::BM_BAR"},
-        { MyBitmaskClass::BM_BAZ, "MyBitmaskClass::BM_BAZ"},
-        { MyBitmaskClass::BM_FOO_BAR, "MyBitmaskClass::BM_FOO_BAR"},
-        { MyBitmaskClass::BM_FOO_BAR_BAZ, "MyBitmaskClass::BM_FOO_BAR_BAZ"},
-    };
-    EnumSymbols< MyBitmaskClass > r(vals);
-    return r;
-}
\ No newline at end of file
+
+#if __cplusplus < 201703L // C++17 static constexpr members are inline
+constexpr EnumSymbols< MyEnumClass >::Sym esyms_data< MyEnumClass >::vals[];
+constexpr uint32_t esyms_data< MyEnumClass >::hash_disp[];
+constexpr EnumSymbols< MyEnumClass >::NameSlot esyms_data< MyEnumClass >::hash_slots[];
+constexpr uint32_t esyms_data< MyEnumClass >::bm_bits[];
+constexpr EnumSymbols< MyEnumClass >::Index esyms_data< MyEnumClass >::idx;
+#endif
+/** enum: auto-generated from myenum.hpp:21: C4_ENUM: MySparseEnum */
+
+#if __cplusplus < 201703L // C++17 static constexpr members are inline
+constexpr EnumSymbols< MySparseEnum >::Sym esyms_data< MySparseEnum >::vals[];
+constexpr uint32_t esyms_data< MySparseEnum >::hash_disp[];
+constexpr EnumSymbols< MySparseEnum >::NameSlot esyms_data< MySparseEnum >::hash_slots[];
+constexpr uint32_t esyms_data< MySparseEnum >::val_syms[];
+constexpr EnumSymbols< MySparseEnum >::Index esyms_data< MySparseEnum >::idx;
+#endif
+/** enum: auto-generated from myenum.hpp:28: C4_ENUM: MyBitmask */
+
+#if __cplusplus < 201703L // C++17 static constexpr members are inline
+constexpr EnumSymbols< MyBitmask >::Sym esyms_data< MyBitmask >::vals[];
+constexpr uint32_t esyms_data< MyBitmask >::hash_disp[];
+constexpr EnumSymbols< MyBitmask >::NameSlot esyms_data< MyBitmask >::hash_slots[];
+constexpr uint32_t esyms_data< MyBitmask >::val_syms[];
+constexpr uint32_t esyms_data< MyBitmask >::bm_composites[];
+constexpr uint32_t esyms_data< MyBitmask >::bm_bits[];
+constexpr EnumSymbols< MyBitmask >::Index esyms_data< MyBitmask >::idx;
+#endif
+/** enum: auto-generated from myenum.hpp:38: C4_ENUM: MyBitmaskClass */
+
+#if __cplusplus < 201703L // C++17 static constexpr members are inline
+constexpr EnumSymbols< MyBitmaskClass >::Sym esyms_data< MyBitmaskClass >::vals[];
+constexpr uint32_t esyms_data< MyBitmaskClass >::hash_disp[];
+constexpr EnumSymbols< MyBitmaskClass >::NameSlot esyms_data< MyBitmaskClass >::hash_slots[];
+constexpr uint32_t esyms_data< MyBitmaskClass >::val_syms[];
+constexpr uint32_t esyms_data< MyBitmaskClass >::bm_composites[];
+constexpr uint32_t esyms_data< MyBitmaskClass >::bm_bits[];
+constexpr EnumSymbols< MyBitmaskClass >::Index esyms_data< MyBitmaskClass >::idx;
+#endif
\ No newline at end of file
@@ -6,26 +6,337 @@
 #include "myenum.hpp"
 
 /** enum: auto-generated from myenum.hpp:7: C4_ENUM: MyEnum */
-template<> const EnumSymbols< MyEnum > esyms();
+
+template<> struct esyms_data< MyEnum >
+{
+    static constexpr EnumSymbols< MyEnum >::Sym vals[] = {
+        { FOO, "FOO", 3, 0, 0},
+        { BAR, "BAR", 3, 0, 0},
+        { BAZ, "BAZ", 3, 0, 0},
+    };
+    static constexpr uint32_t hash_disp[] = {
+        1,
+    };
+    static constexpr EnumSymbols< MyEnum >::NameSlot hash_slots[] = {
+        { 0, 0, 3},
+        { 0, 0, 0},
+        { 1, 0, 3},
+        { 2, 0, 3},
+    };
+    static constexpr uint32_t bm_bits[] = {
+        1, 2,
+    };
+    static constexpr EnumSymbols< MyEnum >::Index idx = {
+        0, 1, 4, hash_disp, hash_slots,
+        0, 3, nullptr,
+        nullptr,
+        0, nullptr, 2, bm_bits,
+        0, 0, nullptr, nullptr,
+    };
+};
+template<> inline const EnumSymbols< MyEnum > esyms()
+{
+    return EnumSymbols< MyEnum >(esyms_data< MyEnum >::vals, &esyms_data< MyEnum >::idx);
+}
+template<> constexpr size_t esize< MyEnum >()
+{
+    return 3;
+}
+template<> inline size_t eindex< MyEnum >(MyEnum v)
+{
+    // the values are contiguous
+    using U = std::make_unsigned< std::underlying_type< MyEnum >::type >::type;
+    U i = static_cast< U >(static_cast< U >(v) - static_cast< U >(0ull));
+    return i < 3 ? i : 3;
+}
+template<> inline MyEnum evalue< MyEnum >(size_t i)
+{
+    using U = std::make_unsigned< std::underlying_type< MyEnum >::type >::type;
+    C4_XASSERT(i < 3);
+    return static_cast< MyEnum >(static_cast< U >(static_cast< U >(0ull) + static_cast< U >(i)));
+}
 
 /** enum: auto-generated from myenum.hpp:14: C4_ENUM: MyEnumClass */
-template<> const EnumSymbols< MyEnumClass > esyms();
+
+template<> struct esyms_data< MyEnumClass >
+{
+    static constexpr EnumSymbols< MyEnumClass >::Sym vals[] = {
+        { MyEnumClass::FOO, "MyEnumClass::FOO", 16, 13, 13},
+        { MyEnumClass::BAR, "MyEnumClass::BAR", 16, 13, 13},
+        { MyEnumClass::BAZ, "MyEnumClass::BAZ", 16, 13, 13},
+    };
+    static constexpr uint32_t hash_disp[] = {
+        0, 2,
+    };
+    static constexpr EnumSymbols< MyEnumClass >::NameSlot hash_slots[] = {
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 1, 13, 3},
+        { 2, 0, 16},
+        { 0, 0, 16},
+        { 0, 13, 3},
+        { 2, 13, 3},
+        { 1, 0, 16},
+    };
+    static constexpr uint32_t bm_bits[] = {
+        1, 2,
+    };
+    static constexpr EnumSymbols< MyEnumClass >::Index idx = {
+        0, 2, 8, hash_disp, hash_slots,
+        0, 3, nullptr,
+        nullptr,
+        0, nullptr, 2, bm_bits,
+        0, 0, nullptr, nullptr,
+    };
+};
+template<> inline const EnumSymbols< MyEnumClass > esyms()
+{
+    return EnumSymbols< MyEnumClass >(esyms_data< MyEnumClass >::vals, &esyms_data< MyEnumClass >::idx);
+}
 template<> inline size_t eoffs_cls< MyEnumClass >()
 {
     // same as strlen("MyEnumClass::")
     return 13;
 }
+template<> constexpr size_t esize< MyEnumClass >()
+{
+    return 3;
+}
+template<> inline size_t eindex< MyEnumClass >(MyEnumClass v)
+{
+    // the values are contiguous
+    using U = std::make_unsigned< std::underlying_type< MyEnumClass >::type >::type;
+    U i = static_cast< U >(static_cast< U >(v) - static_cast< U >(0ull));
+    return i < 3 ? i : 3;
+}
+template<> inline MyEnumClass evalue< MyEnumClass >(size_t i)
+{
+    using U = std::make_unsigned< std::underlying_type< MyEnumClass >::type >::type;
+    C4_XASSERT(i < 3);
+    return static_cast< MyEnumClass >(static_cast< U >(static_cast< U >(0ull) + static_cast< U >(i)));
+}
+
+/** enum: auto-generated from myenum.hpp:21: C4_ENUM: MySparseEnum */
+
+template<> struct esyms_data< MySparseEnum >
+{
+    static constexpr EnumSymbols< MySparseEnum >::Sym vals[] = {
+        { SP_FOO, "SP_FOO", 6, 0, 3},
+        { SP_BAR, "SP_BAR", 6, 0, 3},
+        { SP_BAZ, "SP_BAZ", 6, 0, 3},
+    };
+    static constexpr uint32_t hash_disp[] = {
+        0, 2,
+    };
+    static constexpr EnumSymbols< MySparseEnum >::NameSlot hash_slots[] = {
+        { 1, 0, 6},
+        { 0, 0, 0},
+        { 1, 3, 3},
+        { 0, 0, 0},
+        { 2, 0, 6},
+        { 0, 3, 3},
+        { 2, 3, 3},
+        { 0, 0, 6},
+    };
+    static constexpr uint32_t val_syms[] = {
+        0, 1, 2,
+    };
+    static constexpr EnumSymbols< MySparseEnum >::Index idx = {
+        0, 2, 8, hash_disp, hash_slots,
+        0, 0, val_syms,
+        nullptr,
+        0, nullptr, 0, nullptr,
+        0, 0, nullptr, nullptr,
+    };
+};
+template<> inline const EnumSymbols< MySparseEnum > esyms()
+{
+    return EnumSymbols< MySparseEnum >(esyms_data< MySparseEnum >::vals, &esyms_data< MySparseEnum >::idx);
+}
+template<> inline size_t eoffs_pfx< MySparseEnum >()
+{
+    // same as strlen("SP_")
+    return 3;
+}
+template<> constexpr size_t esize< MySparseEnum >()
+{
+    return 3;
+}
+template<> inline size_t eindex< MySparseEnum >(MySparseEnum v)
+{
+    switch(v)
+    {
+    case SP_FOO: return 0;
+    case SP_BAR: return 1;
+    case SP_BAZ: return 2;
+    default: return 3;
+    }
+}
+template<> inline MySparseEnum evalue< MySparseEnum >(size_t i)
+{
+    static const MySparseEnum vals[] = {
+        SP_FOO, SP_BAR, SP_BAZ,
+    };
+    C4_XASSERT(i < 3);
+    return vals[i];
+}
 
-/** enum: auto-generated from myenum.hpp:21: C4_ENUM: MyBitmask */
-template<> const EnumSymbols< MyBitmask > esyms();
+/** enum: auto-generated from myenum.hpp:28: C4_ENUM: MyBitmask */
+
+template<> struct esyms_data< MyBitmask >
+{
+    static constexpr EnumSymbols< MyBitmask >::Sym vals[] = {
+        { BM_NONE, "BM_NONE", 7, 0, 3},
+        { BM_FOO, "BM_FOO", 6, 0, 3},
+        { BM_BAR, "BM_BAR", 6, 0, 3},
+        { BM_BAZ, "BM_BAZ", 6, 0, 3},
+        { BM_FOO_BAR, "BM_FOO_BAR", 10, 0, 3},
+        { BM_FOO_BAR_BAZ, "BM_FOO_BAR_BAZ", 14, 0, 3},
+    };
+    static constexpr uint32_t hash_disp[] = {
+        0, 4, 3, 34,
+    };
+    static constexpr EnumSymbols< MyBitmask >::NameSlot hash_slots[] = {
+        { 2, 0, 6},
+        { 4, 3, 7},
+        { 0, 0, 7},
+        { 0, 0, 0},
+        { 5, 0, 14},
+        { 5, 3, 11},
+        { 1, 3, 3},
+        { 0, 0, 0},
+        { 3, 0, 6},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 2, 3, 3},
+        { 3, 3, 3},
+        { 0, 3, 4},
+        { 4, 0, 10},
+        { 1, 0, 6},
+    };
+    static constexpr uint32_t val_syms[] = {
+        0, 1, 2, 4, 3, 4294967295, 4294967295, 5,
+    };
+    static constexpr uint32_t bm_composites[] = {
+        5, 4,
+    };
+    static constexpr uint32_t bm_bits[] = {
+        1, 2, 3,
+    };
+    static constexpr EnumSymbols< MyBitmask >::Index idx = {
+        0, 4, 16, hash_disp, hash_slots,
+        0, 8, val_syms,
+        nullptr,
+        2, bm_composites, 3, bm_bits,
+        0, 0, nullptr, nullptr,
+    };
+};
+template<> inline const EnumSymbols< MyBitmask > esyms()
+{
+    return EnumSymbols< MyBitmask >(esyms_data< MyBitmask >::vals, &esyms_data< MyBitmask >::idx);
+}
 template<> inline size_t eoffs_pfx< MyBitmask >()
 {
     // same as strlen("BM_")
     return 3;
 }
+template<> constexpr size_t esize< MyBitmask >()
+{
+    return 6;
+}
+template<> inline size_t eindex< MyBitmask >(MyBitmask v)
+{
+    switch(v)
+    {
+    case BM_NONE: return 0;
+    case BM_FOO: return 1;
+    case BM_BAR: return 2;
+    case BM_FOO_BAR: return 3;
+    case BM_BAZ: return 4;
+    case BM_FOO_BAR_BAZ: return 5;
+    default: return 6;
+    }
+}
+template<> inline MyBitmask evalue< MyBitmask >(size_t i)
+{
+    static const MyBitmask vals[] = {
+        BM_NONE, BM_FOO, BM_BAR, BM_FOO_BAR,
+        BM_BAZ, BM_FOO_BAR_BAZ,
+    };
+    C4_XASSERT(i < 6);
+    return vals[i];
+}
+
+/** enum: auto-generated from myenum.hpp:38: C4_ENUM: MyBitmaskClass */
 
-/** enum: auto-generated from myenum.hpp:31: C4_ENUM: MyBitmaskClass */
-template<> const EnumSymbols< MyBitmaskClass > esyms();
+template<> struct esyms_data< MyBitmaskClass >
+{
+    static constexpr EnumSymbols< MyBitmaskClass >::Sym vals[] = {
+        { MyBitmaskClass::BM_NONE, "MyBitmaskClass::BM_NONE", 23, 16, 19},
+        { MyBitmaskClass::BM_FOO, "MyBitmaskClass::BM_FOO", 22, 16, 19},
+        { MyBitmaskClass::BM_BAR, "MyBitmaskClass::BM_BAR", 22, 16, 19},
+        { MyBitmaskClass::BM_BAZ, "MyBitmaskClass::BM_BAZ", 22, 16, 19},
+        { MyBitmaskClass::BM_FOO_BAR, "MyBitmaskClass::BM_FOO_BAR", 26, 16, 19},
+        { MyBitmaskClass::BM_FOO_BAR_BAZ, "MyBitmaskClass::BM_FOO_BAR_BAZ", 30, 16, 19},
+    };
+    static constexpr uint32_t hash_disp[] = {
+        0, 0, 0, 1, 0, 0, 0, 2,
+    };
+    static constexpr EnumSymbols< MyBitmaskClass >::NameSlot hash_slots[] = {
+        { 2, 16, 6},
+        { 0, 0, 23},
+        { 2, 19, 3},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 1, 19, 3},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 5, 16, 14},
+        { 0, 19, 4},
+        { 1, 0, 22},
+        { 4, 19, 7},
+        { 4, 16, 10},
+        { 4, 0, 26},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 5, 19, 11},
+        { 2, 0, 22},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 0, 16, 7},
+        { 5, 0, 30},
+        { 3, 0, 22},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 3, 19, 3},
+        { 0, 0, 0},
+        { 0, 0, 0},
+        { 1, 16, 6},
+        { 3, 16, 6},
+    };
+    static constexpr uint32_t val_syms[] = {
+        0, 1, 2, 4, 3, 4294967295, 4294967295, 5,
+    };
+    static constexpr uint32_t bm_composites[] = {
+        5, 4,
+    };
+    static constexpr uint32_t bm_bits[] = {
+        1, 2, 3,
+    };
+    static constexpr EnumSymbols< MyBitmaskClass >::Index idx = {
+        0, 8, 32, hash_disp, hash_slots,
+        0, 8, val_syms,
+        nullptr,
+        2, bm_composites, 3, bm_bits,
+        0, 0, nullptr, nullptr,
+    };
+};
+template<> inline const EnumSymbols< MyBitmaskClass > esyms()
+{
+    return EnumSymbols< MyBitmaskClass >(esyms_data< MyBitmaskClass >::vals, &esyms_data< MyBitmaskClass >::idx);
+}
 template<> inline size_t eoffs_cls< MyBitmaskClass >()
 {
     // same as strlen("MyBitmaskClass::")
@@ -36,6 +347,33 @@ template<> inline size_t eoffs_pfx< MyBitmaskClass >()
     // same as strlen("MyBitmaskClass::BM_")
     return 19;
 }
+template<> constexpr size_t esize< MyBitmaskClass >()
+{
+    return 6;
+}
+template<> inline size_t eindex< MyBitmaskClass >(MyBitmaskClass v)
+{
+    switch(v)
+    {
+    case MyBitmaskClass::BM_NONE: return 0;
+    case MyBitmaskClass::BM_FOO: return 1;
+    case MyBitmaskClass::BM_BAR: return 2;
+    case MyBitmaskClass::BM_FOO_BAR: return 3;
+    case MyBitmaskClass::BM_BAZ: return 4;
+    case MyBitmaskClass::BM_FOO_BAR_BAZ: return 5;
+    default: return 6;
+    }
+}
+template<> inline MyBitmaskClass evalue< MyBitmaskClass >(size_t i)
+{
+    static const MyBitmaskClass vals[] = {
+        MyBitmaskClass::BM_NONE, MyBitmaskClass::BM_FOO, MyBitmaskClass::BM_BAR, MyBitmaskClass::BM_FOO_BAR,
+        MyBitmaskClass::BM_BAZ, MyBitmaskClass::BM_FOO_BAR_BAZ,
+    };
+    C4_XASSERT(i < 6);
+    return vals[i];
+}
+
 
 
 
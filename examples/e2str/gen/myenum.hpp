@@ -18,6 +18,13 @@ enum class MyEnumClass {
     BAZ,
 };
 
+C4_ENUM()
+typedef enum {
+    SP_FOO = -10,
+    SP_BAR = 100,
+    SP_BAZ = 1000,
+} MySparseEnum;
+
 C4_ENUM()
 typedef enum {
     BM_NONE = 0,
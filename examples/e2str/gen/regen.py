@@ -2,37 +2,10 @@
 
 import c4.regen as regen
 
-egen = regen.EnumGenerator(
-    hdr="""
-template<> const EnumSymbols< {{enum.type}} > esyms();
-{% if enum.class_offset > 0 %}
-template<> inline size_t eoffs_cls< {{enum.type}} >()
-{
-    // same as strlen("{{enum.class_str}}")
-    return {{enum.class_offset}};
-}
-{% endif %}
-{% if enum.prefix_offset > enum.class_offset %}
-template<> inline size_t eoffs_pfx< {{enum.type}} >()
-{
-    // same as strlen("{{enum.class_str}}{{enum.prefix}}")
-    return {{enum.prefix_offset}};
-}
-{% endif %}
-""",
-    src="""
-template<> const EnumSymbols< {{enum.type}} > esyms()
-{
-    static const EnumSymbols< {{enum.type}} >::Sym vals[] = {
-        {% for e in enum.symbols %}
-        { {{e.name}}, "{{e.name}}"},
-        {% endfor %}
-    };
-    EnumSymbols< {{enum.type}} > r(vals);
-    return r;
-}
-"""
-)
+# use the built-in templates: the symbol tables are static constexpr
+# data in the generated header, and the generated source file has
+# their definitions (needed only before C++17)
+egen = regen.EnumGenerator(storage='constexpr')
 writer = regen.ChunkWriterGenFile()
 
 #------------------------------------------------------------------------------
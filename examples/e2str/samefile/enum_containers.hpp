@@ -0,0 +1 @@
+../../common/include/enum_containers.hpp
\ No newline at end of file
@@ -18,6 +18,13 @@ enum class MyEnumClass {
     BAZ,
 };
 
+C4_ENUM()
+typedef enum {
+    SP_FOO = -10,
+    SP_BAR = 100,
+    SP_BAZ = 1000,
+} MySparseEnum;
+
 C4_ENUM()
 typedef enum {
     BM_NONE = 0,
@@ -40,26 +47,165 @@ enum class MyBitmaskClass {
 
 // regen:GENERATED:(BEGIN). DO NOT EDIT THE BLOCK BELOW. WILL BE OVERWRITTEN!
 /** enum: auto-generated from myenum.hpp:7: C4_ENUM: MyEnum */
+
 template<> inline const EnumSymbols< MyEnum > esyms()
 {
     static const EnumSymbols< MyEnum >::Sym vals[] = {
-        { FOO, "FOO"},
-        { BAR, "BAR"},
-        { BAZ, "BAZ"},
+        { FOO, "FOO", 3, 0, 0},
+        { BAR, "BAR", 3, 0, 0},
+        { BAZ, "BAZ", 3, 0, 0},
+    };
+    struct name_trie
+    {
+        static uint32_t find(const char *s, size_t len)
+        {
+            const uint32_t none = 0xffffffff;
+            switch(len)
+            {
+            case 3:
+                switch(s[0])
+                {
+                case 'B':
+                    if(s[1] != 'A')
+                        return none;
+                    switch(s[2])
+                    {
+                    case 'R':
+                        return 1;
+                    case 'Z':
+                        return 2;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 1, "OO", 2) == 0 ? 0 : none;
+                default:
+                    return none;
+                }
+            default:
+                return none;
+            }
+        }
     };
-    EnumSymbols< MyEnum > r(vals);
+    static const uint32_t bm_bits[] = {
+        1, 2,
+    };
+    // for each byte and each of its values, the names of the bits set
+    static const uint32_t bm_lut_offs[] = {
+        0, 0, 3, 6, 13,
+    };
+    static const char bm_lut_names[] =
+        "" "BAR" "BAZ" "BAR|BAZ"
+        ;
+    static const EnumSymbols< MyEnum >::Index idx = {
+        0, 0, 0, nullptr, nullptr,
+        0, 3, nullptr,
+        &name_trie::find,
+        0, nullptr, 2, bm_bits,
+        3ull, 1, bm_lut_offs, bm_lut_names,
+    };
+    EnumSymbols< MyEnum > r(vals, &idx);
     return r;
 }
+template<> constexpr size_t esize< MyEnum >()
+{
+    return 3;
+}
+template<> inline size_t eindex< MyEnum >(MyEnum v)
+{
+    // the values are contiguous
+    using U = std::make_unsigned< std::underlying_type< MyEnum >::type >::type;
+    U i = static_cast< U >(static_cast< U >(v) - static_cast< U >(0ull));
+    return i < 3 ? i : 3;
+}
+template<> inline MyEnum evalue< MyEnum >(size_t i)
+{
+    using U = std::make_unsigned< std::underlying_type< MyEnum >::type >::type;
+    C4_XASSERT(i < 3);
+    return static_cast< MyEnum >(static_cast< U >(static_cast< U >(0ull) + static_cast< U >(i)));
+}
 
 /** enum: auto-generated from myenum.hpp:14: C4_ENUM: MyEnumClass */
+
 template<> inline const EnumSymbols< MyEnumClass > esyms()
 {
     static const EnumSymbols< MyEnumClass >::Sym vals[] = {
-        { MyEnumClass::FOO, "MyEnumClass::FOO"},
-        { MyEnumClass::BAR, "MyEnumClass::BAR"},
-        { MyEnumClass::BAZ, "MyEnumClass::BAZ"},
+        { MyEnumClass::FOO, "MyEnumClass::FOO", 16, 13, 13},
+        { MyEnumClass::BAR, "MyEnumClass::BAR", 16, 13, 13},
+        { MyEnumClass::BAZ, "MyEnumClass::BAZ", 16, 13, 13},
+    };
+    struct name_trie
+    {
+        static uint32_t find(const char *s, size_t len)
+        {
+            const uint32_t none = 0xffffffff;
+            switch(len)
+            {
+            case 3:
+                switch(s[0])
+                {
+                case 'B':
+                    if(s[1] != 'A')
+                        return none;
+                    switch(s[2])
+                    {
+                    case 'R':
+                        return 1;
+                    case 'Z':
+                        return 2;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 1, "OO", 2) == 0 ? 0 : none;
+                default:
+                    return none;
+                }
+            case 16:
+                if(memcmp(s, "MyEnumClass::", 13) != 0)
+                    return none;
+                switch(s[13])
+                {
+                case 'B':
+                    if(s[14] != 'A')
+                        return none;
+                    switch(s[15])
+                    {
+                    case 'R':
+                        return 1;
+                    case 'Z':
+                        return 2;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 14, "OO", 2) == 0 ? 0 : none;
+                default:
+                    return none;
+                }
+            default:
+                return none;
+            }
+        }
+    };
+    static const uint32_t bm_bits[] = {
+        1, 2,
+    };
+    // for each byte and each of its values, the names of the bits set
+    static const uint32_t bm_lut_offs[] = {
+        0, 0, 3, 6, 13,
+    };
+    static const char bm_lut_names[] =
+        "" "BAR" "BAZ" "BAR|BAZ"
+        ;
+    static const EnumSymbols< MyEnumClass >::Index idx = {
+        0, 0, 0, nullptr, nullptr,
+        0, 3, nullptr,
+        &name_trie::find,
+        0, nullptr, 2, bm_bits,
+        3ull, 1, bm_lut_offs, bm_lut_names,
     };
-    EnumSymbols< MyEnumClass > r(vals);
+    EnumSymbols< MyEnumClass > r(vals, &idx);
     return r;
 }
 template<> inline size_t eoffs_cls< MyEnumClass >()
@@ -67,19 +213,236 @@ template<> inline size_t eoffs_cls< MyEnumClass >()
     // same as strlen("MyEnumClass::")
     return 13;
 }
+template<> constexpr size_t esize< MyEnumClass >()
+{
+    return 3;
+}
+template<> inline size_t eindex< MyEnumClass >(MyEnumClass v)
+{
+    // the values are contiguous
+    using U = std::make_unsigned< std::underlying_type< MyEnumClass >::type >::type;
+    U i = static_cast< U >(static_cast< U >(v) - static_cast< U >(0ull));
+    return i < 3 ? i : 3;
+}
+template<> inline MyEnumClass evalue< MyEnumClass >(size_t i)
+{
+    using U = std::make_unsigned< std::underlying_type< MyEnumClass >::type >::type;
+    C4_XASSERT(i < 3);
+    return static_cast< MyEnumClass >(static_cast< U >(static_cast< U >(0ull) + static_cast< U >(i)));
+}
+
+/** enum: auto-generated from myenum.hpp:21: C4_ENUM: MySparseEnum */
+
+template<> inline const EnumSymbols< MySparseEnum > esyms()
+{
+    static const EnumSymbols< MySparseEnum >::Sym vals[] = {
+        { SP_FOO, "SP_FOO", 6, 0, 3},
+        { SP_BAR, "SP_BAR", 6, 0, 3},
+        { SP_BAZ, "SP_BAZ", 6, 0, 3},
+    };
+    struct name_trie
+    {
+        static uint32_t find(const char *s, size_t len)
+        {
+            const uint32_t none = 0xffffffff;
+            switch(len)
+            {
+            case 3:
+                switch(s[0])
+                {
+                case 'B':
+                    if(s[1] != 'A')
+                        return none;
+                    switch(s[2])
+                    {
+                    case 'R':
+                        return 1;
+                    case 'Z':
+                        return 2;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 1, "OO", 2) == 0 ? 0 : none;
+                default:
+                    return none;
+                }
+            case 6:
+                if(memcmp(s, "SP_", 3) != 0)
+                    return none;
+                switch(s[3])
+                {
+                case 'B':
+                    if(s[4] != 'A')
+                        return none;
+                    switch(s[5])
+                    {
+                    case 'R':
+                        return 1;
+                    case 'Z':
+                        return 2;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 4, "OO", 2) == 0 ? 0 : none;
+                default:
+                    return none;
+                }
+            default:
+                return none;
+            }
+        }
+    };
+    static const uint32_t val_syms[] = {
+        0, 1, 2,
+    };
+    static const EnumSymbols< MySparseEnum >::Index idx = {
+        0, 0, 0, nullptr, nullptr,
+        0, 0, val_syms,
+        &name_trie::find,
+        0, nullptr, 0, nullptr,
+        0, 0, nullptr, nullptr,
+    };
+    EnumSymbols< MySparseEnum > r(vals, &idx);
+    return r;
+}
+template<> inline size_t eoffs_pfx< MySparseEnum >()
+{
+    // same as strlen("SP_")
+    return 3;
+}
+template<> constexpr size_t esize< MySparseEnum >()
+{
+    return 3;
+}
+template<> inline size_t eindex< MySparseEnum >(MySparseEnum v)
+{
+    switch(v)
+    {
+    case SP_FOO: return 0;
+    case SP_BAR: return 1;
+    case SP_BAZ: return 2;
+    default: return 3;
+    }
+}
+template<> inline MySparseEnum evalue< MySparseEnum >(size_t i)
+{
+    static const MySparseEnum vals[] = {
+        SP_FOO, SP_BAR, SP_BAZ,
+    };
+    C4_XASSERT(i < 3);
+    return vals[i];
+}
+
+/** enum: auto-generated from myenum.hpp:28: C4_ENUM: MyBitmask */
 
-/** enum: auto-generated from myenum.hpp:21: C4_ENUM: MyBitmask */
 template<> inline const EnumSymbols< MyBitmask > esyms()
 {
     static const EnumSymbols< MyBitmask >::Sym vals[] = {
-        { BM_NONE, "BM_NONE"},
-        { BM_FOO, "BM_FOO"},
-        { BM_BAR, "BM_BAR"},
-        { BM_BAZ, "BM_BAZ"},
-        { BM_FOO_BAR, "BM_FOO_BAR"},
-        { BM_FOO_BAR_BAZ, "BM_FOO_BAR_BAZ"},
-    };
-    EnumSymbols< MyBitmask > r(vals);
+        { BM_NONE, "BM_NONE", 7, 0, 3},
+        { BM_FOO, "BM_FOO", 6, 0, 3},
+        { BM_BAR, "BM_BAR", 6, 0, 3},
+        { BM_BAZ, "BM_BAZ", 6, 0, 3},
+        { BM_FOO_BAR, "BM_FOO_BAR", 10, 0, 3},
+        { BM_FOO_BAR_BAZ, "BM_FOO_BAR_BAZ", 14, 0, 3},
+    };
+    struct name_trie
+    {
+        static uint32_t find(const char *s, size_t len)
+        {
+            const uint32_t none = 0xffffffff;
+            switch(len)
+            {
+            case 3:
+                switch(s[0])
+                {
+                case 'B':
+                    if(s[1] != 'A')
+                        return none;
+                    switch(s[2])
+                    {
+                    case 'R':
+                        return 2;
+                    case 'Z':
+                        return 3;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 1, "OO", 2) == 0 ? 1 : none;
+                default:
+                    return none;
+                }
+            case 4:
+                return memcmp(s, "NONE", 4) == 0 ? 0 : none;
+            case 6:
+                if(memcmp(s, "BM_", 3) != 0)
+                    return none;
+                switch(s[3])
+                {
+                case 'B':
+                    if(s[4] != 'A')
+                        return none;
+                    switch(s[5])
+                    {
+                    case 'R':
+                        return 2;
+                    case 'Z':
+                        return 3;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 4, "OO", 2) == 0 ? 1 : none;
+                default:
+                    return none;
+                }
+            case 7:
+                switch(s[0])
+                {
+                case 'B':
+                    return memcmp(s + 1, "M_NONE", 6) == 0 ? 0 : none;
+                case 'F':
+                    return memcmp(s + 1, "OO_BAR", 6) == 0 ? 4 : none;
+                default:
+                    return none;
+                }
+            case 10:
+                return memcmp(s, "BM_FOO_BAR", 10) == 0 ? 4 : none;
+            case 11:
+                return memcmp(s, "FOO_BAR_BAZ", 11) == 0 ? 5 : none;
+            case 14:
+                return memcmp(s, "BM_FOO_BAR_BAZ", 14) == 0 ? 5 : none;
+            default:
+                return none;
+            }
+        }
+    };
+    static const uint32_t val_syms[] = {
+        0, 1, 2, 4, 3, 4294967295, 4294967295, 5,
+    };
+    static const uint32_t bm_composites[] = {
+        5, 4,
+    };
+    static const uint32_t bm_bits[] = {
+        1, 2, 3,
+    };
+    // for each byte and each of its values, the names of the bits set
+    static const uint32_t bm_lut_offs[] = {
+        0, 0, 3, 6, 13, 16, 23, 30, 41,
+    };
+    static const char bm_lut_names[] =
+        "" "FOO" "BAR" "FOO|BAR" "BAZ" "FOO|BAZ" "BAR|BAZ" "FOO|BAR|BAZ"
+        ;
+    static const EnumSymbols< MyBitmask >::Index idx = {
+        0, 0, 0, nullptr, nullptr,
+        0, 8, val_syms,
+        &name_trie::find,
+        2, bm_composites, 3, bm_bits,
+        7ull, 1, bm_lut_offs, bm_lut_names,
+    };
+    EnumSymbols< MyBitmask > r(vals, &idx);
     return r;
 }
 template<> inline size_t eoffs_pfx< MyBitmask >()
@@ -87,19 +450,169 @@ template<> inline size_t eoffs_pfx< MyBitmask >()
     // same as strlen("BM_")
     return 3;
 }
+template<> constexpr size_t esize< MyBitmask >()
+{
+    return 6;
+}
+template<> inline size_t eindex< MyBitmask >(MyBitmask v)
+{
+    switch(v)
+    {
+    case BM_NONE: return 0;
+    case BM_FOO: return 1;
+    case BM_BAR: return 2;
+    case BM_FOO_BAR: return 3;
+    case BM_BAZ: return 4;
+    case BM_FOO_BAR_BAZ: return 5;
+    default: return 6;
+    }
+}
+template<> inline MyBitmask evalue< MyBitmask >(size_t i)
+{
+    static const MyBitmask vals[] = {
+        BM_NONE, BM_FOO, BM_BAR, BM_FOO_BAR,
+        BM_BAZ, BM_FOO_BAR_BAZ,
+    };
+    C4_XASSERT(i < 6);
+    return vals[i];
+}
+
+/** enum: auto-generated from myenum.hpp:38: C4_ENUM: MyBitmaskClass */
 
-/** enum: auto-generated from myenum.hpp:31: C4_ENUM: MyBitmaskClass */
 template<> inline const EnumSymbols< MyBitmaskClass > esyms()
 {
     static const EnumSymbols< MyBitmaskClass >::Sym vals[] = {
-        { MyBitmaskClass::BM_NONE, "MyBitmaskClass::BM_NONE"},
-        { MyBitmaskClass::BM_FOO, "MyBitmaskClass::BM_FOO"},
-        { MyBitmaskClass::BM_BAR, "MyBitmaskClass::BM_BAR"},
-        { MyBitmaskClass::BM_BAZ, "MyBitmaskClass::BM_BAZ"},
-        { MyBitmaskClass::BM_FOO_BAR, "MyBitmaskClass::BM_FOO_BAR"},
-        { MyBitmaskClass::BM_FOO_BAR_BAZ, "MyBitmaskClass::BM_FOO_BAR_BAZ"},
-    };
-    EnumSymbols< MyBitmaskClass > r(vals);
+        { MyBitmaskClass::BM_NONE, "MyBitmaskClass::BM_NONE", 23, 16, 19},
+        { MyBitmaskClass::BM_FOO, "MyBitmaskClass::BM_FOO", 22, 16, 19},
+        { MyBitmaskClass::BM_BAR, "MyBitmaskClass::BM_BAR", 22, 16, 19},
+        { MyBitmaskClass::BM_BAZ, "MyBitmaskClass::BM_BAZ", 22, 16, 19},
+        { MyBitmaskClass::BM_FOO_BAR, "MyBitmaskClass::BM_FOO_BAR", 26, 16, 19},
+        { MyBitmaskClass::BM_FOO_BAR_BAZ, "MyBitmaskClass::BM_FOO_BAR_BAZ", 30, 16, 19},
+    };
+    struct name_trie
+    {
+        static uint32_t find(const char *s, size_t len)
+        {
+            const uint32_t none = 0xffffffff;
+            switch(len)
+            {
+            case 3:
+                switch(s[0])
+                {
+                case 'B':
+                    if(s[1] != 'A')
+                        return none;
+                    switch(s[2])
+                    {
+                    case 'R':
+                        return 2;
+                    case 'Z':
+                        return 3;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 1, "OO", 2) == 0 ? 1 : none;
+                default:
+                    return none;
+                }
+            case 4:
+                return memcmp(s, "NONE", 4) == 0 ? 0 : none;
+            case 6:
+                if(memcmp(s, "BM_", 3) != 0)
+                    return none;
+                switch(s[3])
+                {
+                case 'B':
+                    if(s[4] != 'A')
+                        return none;
+                    switch(s[5])
+                    {
+                    case 'R':
+                        return 2;
+                    case 'Z':
+                        return 3;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 4, "OO", 2) == 0 ? 1 : none;
+                default:
+                    return none;
+                }
+            case 7:
+                switch(s[0])
+                {
+                case 'B':
+                    return memcmp(s + 1, "M_NONE", 6) == 0 ? 0 : none;
+                case 'F':
+                    return memcmp(s + 1, "OO_BAR", 6) == 0 ? 4 : none;
+                default:
+                    return none;
+                }
+            case 10:
+                return memcmp(s, "BM_FOO_BAR", 10) == 0 ? 4 : none;
+            case 11:
+                return memcmp(s, "FOO_BAR_BAZ", 11) == 0 ? 5 : none;
+            case 14:
+                return memcmp(s, "BM_FOO_BAR_BAZ", 14) == 0 ? 5 : none;
+            case 22:
+                if(memcmp(s, "MyBitmaskClass::BM_", 19) != 0)
+                    return none;
+                switch(s[19])
+                {
+                case 'B':
+                    if(s[20] != 'A')
+                        return none;
+                    switch(s[21])
+                    {
+                    case 'R':
+                        return 2;
+                    case 'Z':
+                        return 3;
+                    default:
+                        return none;
+                    }
+                case 'F':
+                    return memcmp(s + 20, "OO", 2) == 0 ? 1 : none;
+                default:
+                    return none;
+                }
+            case 23:
+                return memcmp(s, "MyBitmaskClass::BM_NONE", 23) == 0 ? 0 : none;
+            case 26:
+                return memcmp(s, "MyBitmaskClass::BM_FOO_BAR", 26) == 0 ? 4 : none;
+            case 30:
+                return memcmp(s, "MyBitmaskClass::BM_FOO_BAR_BAZ", 30) == 0 ? 5 : none;
+            default:
+                return none;
+            }
+        }
+    };
+    static const uint32_t val_syms[] = {
+        0, 1, 2, 4, 3, 4294967295, 4294967295, 5,
+    };
+    static const uint32_t bm_composites[] = {
+        5, 4,
+    };
+    static const uint32_t bm_bits[] = {
+        1, 2, 3,
+    };
+    // for each byte and each of its values, the names of the bits set
+    static const uint32_t bm_lut_offs[] = {
+        0, 0, 3, 6, 13, 16, 23, 30, 41,
+    };
+    static const char bm_lut_names[] =
+        "" "FOO" "BAR" "FOO|BAR" "BAZ" "FOO|BAZ" "BAR|BAZ" "FOO|BAR|BAZ"
+        ;
+    static const EnumSymbols< MyBitmaskClass >::Index idx = {
+        0, 0, 0, nullptr, nullptr,
+        0, 8, val_syms,
+        &name_trie::find,
+        2, bm_composites, 3, bm_bits,
+        7ull, 1, bm_lut_offs, bm_lut_names,
+    };
+    EnumSymbols< MyBitmaskClass > r(vals, &idx);
     return r;
 }
 template<> inline size_t eoffs_cls< MyBitmaskClass >()
@@ -112,6 +625,33 @@ template<> inline size_t eoffs_pfx< MyBitmaskClass >()
     // same as strlen("MyBitmaskClass::BM_")
     return 19;
 }
+template<> constexpr size_t esize< MyBitmaskClass >()
+{
+    return 6;
+}
+template<> inline size_t eindex< MyBitmaskClass >(MyBitmaskClass v)
+{
+    switch(v)
+    {
+    case MyBitmaskClass::BM_NONE: return 0;
+    case MyBitmaskClass::BM_FOO: return 1;
+    case MyBitmaskClass::BM_BAR: return 2;
+    case MyBitmaskClass::BM_FOO_BAR: return 3;
+    case MyBitmaskClass::BM_BAZ: return 4;
+    case MyBitmaskClass::BM_FOO_BAR_BAZ: return 5;
+    default: return 6;
+    }
+}
+template<> inline MyBitmaskClass evalue< MyBitmaskClass >(size_t i)
+{
+    static const MyBitmaskClass vals[] = {
+        MyBitmaskClass::BM_NONE, MyBitmaskClass::BM_FOO, MyBitmaskClass::BM_BAR, MyBitmaskClass::BM_FOO_BAR,
+        MyBitmaskClass::BM_BAZ, MyBitmaskClass::BM_FOO_BAR_BAZ,
+    };
+    C4_XASSERT(i < 6);
+    return vals[i];
+}
+
 
 
 
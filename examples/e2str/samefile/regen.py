@@ -2,33 +2,9 @@
 
 import c4.regen as regen
 
-egen = regen.EnumGenerator(
-    inl="""
-template<> inline const EnumSymbols< {{enum.type}} > esyms()
-{
-    static const EnumSymbols< {{enum.type}} >::Sym vals[] = {
-        {% for e in enum.symbols %}
-        { {{e.name}}, "{{e.name}}"},
-        {% endfor %}
-    };
-    EnumSymbols< {{enum.type}} > r(vals);
-    return r;
-}
-{% if enum.class_offset > 0 %}
-template<> inline size_t eoffs_cls< {{enum.type}} >()
-{
-    // same as strlen("{{enum.class_str}}")
-    return {{enum.class_offset}};
-}
-{% endif %}
-{% if enum.prefix_offset > enum.class_offset %}
-template<> inline size_t eoffs_pfx< {{enum.type}} >()
-{
-    // same as strlen("{{enum.class_str}}{{enum.prefix}}")
-    return {{enum.prefix_offset}};
-}
-{% endif %}
-""")
+# use the built-in templates: esyms() is defined inline, and the names
+# are looked up with nested switches instead of a hash table
+egen = regen.EnumGenerator(storage='inl', str2e='trie', bitmask='lut')
 
 writer = regen.ChunkWriterSameFile()
 
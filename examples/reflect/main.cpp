@@ -4,34 +4,128 @@
 #include "main.hpp"
 #include "main.gen.hpp"
 
-#include <vector>
-namespace c4 {
-template< class T, class Allocator >
-struct serialize_category< std::vector< T, Allocator > >
+#include "serialize_std.hpp"
+
+static std::string read_file(const char *filename)
 {
-    enum : int { value = (int)SerializeCategory_e::CUSTOM };
-};
-} // namespace c4
-template< class T, class Allocator, class Stream >
-void serialize(c4::Archive< Stream > &a, const char *name, std::vector< T, Allocator > *var)
+    std::string s;
+    FILE *f = fopen(filename, "rb");
+    C4_CHECK(f != nullptr);
+    char buf[256];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        s.append(buf, n);
+    fclose(f);
+    return s;
+}
+
+/** write the standard containers with the stream, and read them back */
+template< class Stream >
+void check_std_containers(const char *filename)
 {
-    if(a.write_mode())
-    {
-        serialize(a, "size", var->size());
-        serialize(a, "elms", var->data(), var->size());
-    }
-    else
+    std::vector< int > vi{1, -2, 300}, vic{7};
+    std::vector< TestStruct > vts{{1, 2, 3}, {4, 5, 6}}, vtsc;
+    std::vector< std::vector< uint16_t > > vv{{1, 2}, {}, {3}}, vvc;
+    std::vector< bool > vb{true, false, true, true}, vbc;
+    std::string s("hello world"), sc("x"), empty, emptyc("y");
+    std::array< int, 4 > ar{{4, 3, 2, 1}}, arc{};
+    std::map< int, float > m{{3, 3.5f}, {1, 1.5f}, {2, 2.5f}}, mc{{10, 0.f}};
+    std::unordered_map< std::string, std::vector< int > > um{{"a", {1}}, {"bb", {2, 3}}, {"", {}}}, umc;
+    std::map< int, bool > mb{{5, true}, {-1, false}, {7, true}}, mbc;
+    std::unordered_map< bool, std::string > ub{{true, "yes"}, {false, ""}}, ubc;
+    c4::Archive< Stream > ark;
+    FILE *output = fopen(filename, "wb");
+    ark.write_mode(true, output);
+    ark("vi", &vi);
+    ark("vts", &vts);
+    ark("vv", &vv);
+    ark("vb", &vb);
+    ark("s", &s);
+    ark("empty", &empty);
+    ark("ar", &ar);
+    ark("m", &m);
+    ark("um", &um);
+    ark("mb", &mb);
+    ark("ub", &ub);
+    ark.flush();
+    fclose(output);
+
+    FILE *input = fopen(filename, "rb");
+    ark.write_mode(false, input);
+    ark("vi", &vic);
+    ark("vts", &vtsc);
+    ark("vv", &vvc);
+    ark("vb", &vbc);
+    ark("s", &sc);
+    ark("empty", &emptyc);
+    ark("ar", &arc);
+    ark("m", &mc);
+    ark("um", &umc);
+    ark("mb", &mbc);
+    ark("ub", &ubc);
+    ark.flush();
+    fclose(input);
+    C4_CHECK(vic == vi && vvc == vv && vbc == vb && sc == s && emptyc == empty);
+    C4_CHECK(arc == ar && mc == m && umc == um && mbc == mb && ubc == ub);
+    C4_CHECK(vtsc.size() == vts.size() && memcmp(vtsc.data(), vts.data(), sizeof(TestStruct) * vts.size()) == 0);
+}
+
+/** write arrays of CUSTOM_TXT classes column by column with the stream,
+ * and read them back: whole, and a column at a time */
+template< class Stream >
+void check_columns(const char *filename)
+{
+    const int N = 10;
+    int i = 1, ic = 0, after = 1234, afterc = 0;
+    TestStruct tsa[N], tsb[N];
+    TestStructV2 v2a[N], v2b[N];
+    for(int j = 0; j < N; ++j)
     {
-        size_t sz;
-        serialize(a, "size", &sz);
-        var->resize(sz);
-        serialize(a, "elms", var->data(), var->size());
+        tsa[j] = TestStruct{float(j), 0.5f * j, -float(j)};
+        v2a[j] = TestStructV2{1.5 * j, float(j * j), int32_t(-j)};
     }
+    c4::Archive< Stream > ark;
+    FILE *output = fopen(filename, "wb");
+    ark.write_mode(true, output);
+    ark("i", &i);
+    ark.columns("tsa", tsa, N);
+    ark.columns("v2a", v2a, N);
+    ark("after", &after);
+    ark.flush();
+    fclose(output);
+
+    FILE *input = fopen(filename, "rb");
+    ark.write_mode(false, input);
+    ark("i", &ic);
+    ark.columns("tsa", tsb, N);
+    ark.columns("v2a", v2b, N);
+    ark("after", &afterc);
+    ark.flush();
+    fclose(input);
+    C4_CHECK(ic == i && afterc == after);
+    C4_CHECK(memcmp(tsb, tsa, sizeof(tsa)) == 0 && memcmp(v2b, v2a, sizeof(v2a)) == 0);
+
+    // the other columns are skipped
+    float ys[N];
+    int32_t ws[N];
+    input = fopen(filename, "rb");
+    ark.write_mode(false, input);
+    ark("i", &ic);
+    ark.template column< TestStruct >("tsa", "y", ys, N);
+    ark.template column< TestStructV2 >("v2a", "w", ws, N);
+    ark("after", &afterc);
+    ark.flush();
+    fclose(input);
+    C4_CHECK(afterc == after);
+    for(int j = 0; j < N; ++j)
+        C4_CHECK(ys[j] == tsa[j].y && ws[j] == v2a[j].w);
 }
 
 int main(int argc, char* argv[])
 {
     printf("hello\n");
+    printf("%s %s\n", e2str(TE_1), e2str(TestEnumClass_e::TEC_8));
+    C4_CHECK(str2e< TestEnumClass_e >("TEC_8") == TestEnumClass_e::TEC_8);
 #define N 10
 
     int i = 1, ic = 10;
@@ -48,7 +142,7 @@ int main(int argc, char* argv[])
         txt("i", &ic);
         txt("arr", &arrc);
         txt("ts2", &ts2);
-        //c4::serialize(txt, "v2", &v2);
+        c4::serialize(txt, "v2", &v2);
     }
 
     {
@@ -78,6 +172,481 @@ int main(int argc, char* argv[])
         txt("ts2", &ts2);
     }
 
+    // the buffered stream must give the same output
+    {
+        TestStruct tsa[N], tsb[N];
+        for(int j = 0; j < N; ++j)
+            tsa[j] = TestStruct{float(j), float(2*j), float(3*j)};
+        c4::Archive< c4::ArchiveStreamBinaryBuffered > bark;
+        FILE *output = fopen("archive_buffered.bin", "wb");
+        bark.write_mode(true, output);
+        bark("i", &i);
+        bark("arr", &arr);
+        bark("ts1", &ts1);
+        bark("tsa", &tsa);
+        bark.flush();
+        fclose(output);
+
+        arktype ark;
+        FILE *input = fopen("archive_buffered.bin", "rb");
+        ark.write_mode(false, input);
+        ark("i", &ic);
+        ark("arr", &arrc);
+        ark("ts1", &ts2);
+        ark("tsa", &tsb);
+        fclose(input);
+        C4_CHECK(ic == i && memcmp(arrc, arr, sizeof(arr)) == 0);
+        C4_CHECK(memcmp(&ts2, &ts1, sizeof(ts1)) == 0 && memcmp(tsb, tsa, sizeof(tsa)) == 0);
+
+        input = fopen("archive_buffered.bin", "rb");
+        bark.write_mode(false, input);
+        bark("i", &ic);
+        bark("arr", &arrc);
+        bark("ts1", &ts2);
+        bark.flush();
+        // the file position is right after the data read
+        ark.write_mode(false, input);
+        ark("tsa", &tsb);
+        fclose(input);
+        C4_CHECK(ic == i && memcmp(tsb, tsa, sizeof(tsa)) == 0);
+
+        // read in place from a mapping of the file
+        c4::Archive< c4::ArchiveStreamMapped > mark;
+        mark.write_mode(false, "archive_buffered.bin");
+        int arrv[N];
+        mark("i", &ic);
+        int const* parr = mark.view("arr", N, arrv);
+        mark("ts1", &ts2);
+        mark("tsa", &tsb);
+        C4_CHECK(ic == i && memcmp(parr, arr, sizeof(arr)) == 0);
+        C4_CHECK(memcmp(&ts2, &ts1, sizeof(ts1)) == 0 && memcmp(tsb, tsa, sizeof(tsa)) == 0);
+
+        // TestStruct is a pod without padding, so the generated code
+        // makes binary archives copy it with memcpy(), and arrays of it
+        // can be viewed in place
+        static_assert(c4::serialize_category< TestStruct >::value == (int)c4::SerializeCategory_e::CUSTOM_TXT, "");
+        static_assert(c4::serialize_category< TestTpl< uint32_t > >::value == (int)c4::SerializeCategory_e::METHOD, "");
+        mark.write_mode(false, "archive_buffered.bin");
+        mark("i", &ic);
+        mark("arr", &arrc);
+        mark("ts1", &ts2);
+        TestStruct const* ptsa = mark.view("tsa", N, tsb);
+        C4_CHECK(memcmp(ptsa, tsa, sizeof(tsa)) == 0);
+    }
+
+    // the buffered text stream must give the same output as the text
+    // stream, and read it back
+    {
+        TestStruct tsa[N], tsb[N];
+        for(int j = 0; j < N; ++j)
+            tsa[j] = TestStruct{float(j), -0.5f * j, 1.e7f * j};
+        c4::Archive< c4::ArchiveStreamText > tark;
+        FILE *output = fopen("archive.txt", "wb");
+        tark.write_mode(true, output);
+        tark("i", &i);
+        tark("arr", &arr);
+        tark("ts1", &ts1);
+        tark("tsa", &tsa);
+        fclose(output);
+
+        c4::Archive< c4::ArchiveStreamTextBuffered > fark;
+        output = fopen("archive_buffered.txt", "wb");
+        fark.write_mode(true, output);
+        fark("i", &i);
+        fark("arr", &arr);
+        fark("ts1", &ts1);
+        fark("tsa", &tsa);
+        fark.flush();
+        fclose(output);
+        C4_CHECK(read_file("archive.txt") == read_file("archive_buffered.txt"));
+
+        fark.write_mode(false, "archive.txt");
+        fark("i", &ic);
+        fark("arr", &arrc);
+        fark("ts1", &ts2);
+        fark("tsa", &tsb);
+        C4_CHECK(ic == i && memcmp(arrc, arr, sizeof(arr)) == 0);
+        C4_CHECK(memcmp(&ts2, &ts1, sizeof(ts1)) == 0 && memcmp(tsb, tsa, sizeof(tsa)) == 0);
+
+        // values which need more than 6 digits are not rounded, and can
+        // also be read with the text stream
+        for(int j = 0; j < N; ++j)
+            tsa[j] = TestStruct{1.f / (j + 3), -1.e-20f * j / 7, 123456789.f * j};
+        output = fopen("archive_buffered.txt", "wb");
+        fark.write_mode(true, output);
+        fark("tsa", &tsa);
+        fark.flush();
+        fclose(output);
+        fark.write_mode(false, "archive_buffered.txt");
+        fark("tsa", &tsb);
+        C4_CHECK(memcmp(tsb, tsa, sizeof(tsa)) == 0);
+        FILE *input = fopen("archive_buffered.txt", "rb");
+        tark.write_mode(false, input);
+        tark("tsa", &tsb);
+        fclose(input);
+        C4_CHECK(memcmp(tsb, tsa, sizeof(tsa)) == 0);
+    }
+
+    // archives with field tags skip unknown fields, leave missing ones
+    // unchanged, and read a later version of a class
+    {
+        TestStruct tsa[N], tsb[N];
+        for(int j = 0; j < N; ++j)
+            tsa[j] = TestStruct{float(j), -0.5f * j, 1.5f * j};
+        double extra = 3.5;
+        TestTpl< uint32_t > tta[3] = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+        TestTpl< int64_t > ttb[4] = {};
+        c4::Archive< c4::ArchiveStreamTagged > gark;
+        FILE *output = fopen("archive_tagged.bin", "wb");
+        gark.write_mode(true, output);
+        gark("i", &i);
+        gark("extra", &extra);
+        gark("arr", &arr);
+        gark("ts1", &ts1);
+        gark("tsa", &tsa);
+        gark("tta", &tta);
+        gark.flush();
+        fclose(output);
+
+        ic = -1;
+        memset(arrc, 0, sizeof(arrc));
+        memset(&ts2, 0, sizeof(ts2));
+        memset(tsb, 0, sizeof(tsb));
+        int missing = 42;
+        gark.write_mode(false, "archive_tagged.bin");
+        gark("tta", &ttb); // in another order, and with other types
+        gark("tsa", &tsb);
+        gark("missing", &missing);
+        gark("i", &ic);
+        gark("arr", &arrc);
+        gark("ts1", &ts2);
+        C4_CHECK(ic == i && memcmp(arrc, arr, sizeof(arr)) == 0 && missing == 42);
+        C4_CHECK(memcmp(&ts2, &ts1, sizeof(ts1)) == 0 && memcmp(tsb, tsa, sizeof(tsa)) == 0);
+        for(int j = 0; j < 3; ++j)
+            C4_CHECK(ttb[j].r == tta[j].r && ttb[j].g == tta[j].g && ttb[j].b == tta[j].b && ttb[j].a == tta[j].a);
+        C4_CHECK(ttb[3].r == 0 && ttb[3].a == 0);
+
+        // other types are converted, also in the fields of CUSTOM_TXT classes
+        int64_t i64 = 0;
+        float fextra = 0;
+        TestStructV2 v2a[N];
+        for(int j = 0; j < N; ++j)
+            v2a[j] = TestStructV2{0., 0.f, -j};
+        gark.write_mode(false, "archive_tagged.bin");
+        gark("tsa", &v2a);
+        gark("i", &i64);
+        gark("extra", &fextra);
+        C4_CHECK(i64 == i && fextra == 3.5f);
+        for(int j = 0; j < N; ++j)
+            C4_CHECK(v2a[j].x == tsa[j].x && v2a[j].z == double(tsa[j].z) && v2a[j].w == -j);
+    }
+
+    // varint archives take one byte for small integers of any width
+    {
+        int64_t small[3 * N], smallc[3 * N];
+        for(int j = 0; j < 3 * N; ++j)
+            small[j] = j % 2 ? -j : j;
+        small[7] = INT64_MIN;
+        small[8] = INT64_MAX;
+        uint16_t u16 = 300, u16c = 0;
+        TestEnumClass_e e = TestEnumClass_e::TEC_8, ec = TestEnumClass_e::TEC_1;
+        c4::Archive< c4::ArchiveStreamVarint > vark;
+        FILE *output = fopen("archive_varint.bin", "wb");
+        vark.write_mode(true, output);
+        vark("i", &i);
+        vark("small", &small);
+        vark("u16", &u16);
+        vark("e", &e);
+        vark("ts1", &ts1);
+        vark.flush();
+        C4_CHECK(ftell(output) == long(1 + (3 * N - 2 + 2 * 10) + 2 + 1 + sizeof(ts1)));
+        fclose(output);
+
+        vark.write_mode(false, "archive_varint.bin");
+        vark("i", &ic);
+        vark("small", &smallc);
+        vark("u16", &u16c);
+        vark("e", &ec);
+        vark("ts1", &ts2);
+        C4_CHECK(ic == i && memcmp(smallc, small, sizeof(small)) == 0);
+        C4_CHECK(u16c == u16 && ec == e && memcmp(&ts2, &ts1, sizeof(ts1)) == 0);
+
+        // values at the end of the input are read byte by byte; they
+        // must give the same as the single load with room to spare
+        const uint64_t vals[] = {0x7f, 300, 0x1fffff, 1ull << 35, 0x00ffffffffffffffull, 1ull << 56, UINT64_MAX};
+        for(uint64_t val : vals)
+        {
+            char buf[16] = {};
+            size_t n = c4::detail::varint_encode(buf, val);
+            uint64_t end = 0, room = 0;
+            C4_CHECK(c4::detail::varint_decode(buf, buf + n, &end) == buf + n);
+            C4_CHECK(c4::detail::varint_decode(buf, buf + sizeof(buf), &room) == buf + n);
+            C4_CHECK(end == val && room == val);
+            C4_CHECK(n == 1 || c4::detail::varint_decode(buf, buf + n - 1, &end) == nullptr);
+            uint16_t narrow = 0;
+            C4_CHECK((c4::detail::varint_decode(buf, buf + n, &narrow) != nullptr) == (val <= UINT16_MAX));
+        }
+    }
+
+    // the standard containers
+    check_std_containers< c4::ArchiveStreamTextBuffered >("archive_std.txt");
+    check_std_containers< c4::ArchiveStreamVarint >("archive_std_varint.bin");
+    check_std_containers< c4::ArchiveStreamTagged >("archive_std_tagged.bin");
+
+    // archives with a given byte order: the same bytes on any host
+    {
+        using c4::Endian_e;
+        int32_t i32 = 0x01020304, i32c = 0;
+        uint16_t u16[3] = {0x0102, 0x0304, 0x0506}, u16c[3] = {};
+        double d = 1.5, dc = 0;
+        TestStruct tsa[N], tsb[N];
+        for(int j = 0; j < N; ++j)
+            tsa[j] = TestStruct{float(j), -0.5f * j, 1.5f * j};
+        c4::Archive< c4::ArchiveStreamBinaryEndian< Endian_e::BIG > > beark;
+        FILE *output = fopen("archive_big.bin", "wb");
+        beark.write_mode(true, output);
+        beark("i32", &i32);
+        beark("u16", &u16);
+        beark("d", &d);
+        beark("tsa", &tsa);
+        beark.flush();
+        fclose(output);
+        std::string big = read_file("archive_big.bin");
+        C4_CHECK(big.compare(0, 10, "\x01\x02\x03\x04\x01\x02\x03\x04\x05\x06", 10) == 0);
+        C4_CHECK(big.compare(10, 8, "\x3f\xf8\x00\x00\x00\x00\x00\x00", 8) == 0);
+        C4_CHECK(big.compare(18, 4, "\x00\x00\x00\x00", 4) == 0 && big.compare(22, 4, "\x80\x00\x00\x00", 4) == 0);
+        C4_CHECK(big.compare(30, 4, "\x3f\x80\x00\x00", 4) == 0); // tsa[1].x
+
+        FILE *input = fopen("archive_big.bin", "rb");
+        beark.write_mode(false, input);
+        beark("i32", &i32c);
+        beark("u16", &u16c);
+        beark("d", &dc);
+        beark("tsa", &tsb);
+        beark.flush();
+        fclose(input);
+        C4_CHECK(i32c == i32 && memcmp(u16c, u16, sizeof(u16)) == 0 && dc == d);
+        C4_CHECK(memcmp(tsb, tsa, sizeof(tsa)) == 0);
+
+        // the native byte order is the plain binary format
+        c4::Archive< c4::ArchiveStreamBinaryEndian< Endian_e::NATIVE > > neark;
+        c4::Archive< c4::ArchiveStreamBinaryBuffered > bark;
+        output = fopen("archive_native.bin", "wb");
+        neark.write_mode(true, output);
+        neark("i32", &i32);
+        neark("tsa", &tsa);
+        neark.flush();
+        fclose(output);
+        output = fopen("archive_buffered.bin", "wb");
+        bark.write_mode(true, output);
+        bark("i32", &i32);
+        bark("tsa", &tsa);
+        bark.flush();
+        fclose(output);
+        C4_CHECK(read_file("archive_native.bin") == read_file("archive_buffered.bin"));
+        check_std_containers< c4::ArchiveStreamBinaryEndian< Endian_e::BIG > >("archive_std_big.bin");
+    }
+
+    // the asynchronous stream writes the plain binary format
+    {
+        TestStruct tsa[N], tsb[N];
+        for(int j = 0; j < N; ++j)
+            tsa[j] = TestStruct{float(j), 2.f * j, -3.f * j};
+        c4::Archive< c4::ArchiveStreamBinaryAsync > aark;
+        FILE *output = fopen("archive_async.bin", "wb");
+        aark.write_mode(true, output, /*block*/16); // small, to use both buffers
+        aark("i", &i);
+        aark("tsa", &tsa);
+        std::future< int > done = aark.finish();
+        aark("arr", &arr); // while the previous data is written
+        C4_CHECK(done.get() == 0);
+        aark.flush();
+        fclose(output);
+        c4::Archive< c4::ArchiveStreamBinaryBuffered > bark;
+        output = fopen("archive_buffered.bin", "wb");
+        bark.write_mode(true, output);
+        bark("i", &i);
+        bark("tsa", &tsa);
+        bark("arr", &arr);
+        bark.flush();
+        fclose(output);
+        C4_CHECK(read_file("archive_async.bin") == read_file("archive_buffered.bin"));
+
+        FILE *input = fopen("archive_async.bin", "rb");
+        aark.write_mode(false, input);
+        aark("i", &ic);
+        aark("tsa", &tsb);
+        aark("arr", &arrc);
+        aark.flush();
+        fclose(input);
+        C4_CHECK(ic == i && memcmp(tsb, tsa, sizeof(tsa)) == 0 && memcmp(arrc, arr, sizeof(arr)) == 0);
+        check_std_containers< c4::ArchiveStreamBinaryAsync >("archive_std_async.bin");
+
+        // write errors are given by the future
+        input = fopen("archive_async.bin", "rb");
+        aark.write_mode(true, input);
+        aark("tsa", &tsa);
+        C4_CHECK(aark.finish().get() != 0);
+        aark.flush();
+        fclose(input);
+    }
+
+    // read single variables with the index at the end of the archive
+    {
+        TestStruct tsa[N], tsb[N];
+        for(int j = 0; j < N; ++j)
+            tsa[j] = TestStruct{float(j), 3.f * j, 0.25f * j};
+        std::vector< TestStruct > vts(tsa, tsa + N), vtsc;
+        std::vector< std::vector< uint16_t > > vv{{1, 2}, {}, {3, 4, 5}};
+        std::vector< uint16_t > vvc;
+        TestTpl< uint32_t > tpl{1, 2, 3, 4};
+        uint32_t g = 0;
+        c4::Archive< c4::ArchiveStreamIndexed > xark;
+        FILE *output = fopen("archive_indexed.bin", "wb");
+        xark.write_mode(true, output);
+        xark("i", &i);
+        xark("arr", &arr);
+        xark("ts1", &ts1);
+        xark("tsa", &tsa);
+        xark("vts", &vts);
+        xark("vv", &vv);
+        xark("tpl", &tpl);
+        xark.flush();
+        fclose(output);
+
+        xark.write_mode(false, "archive_indexed.bin");
+        xark.at("tpl/g", &g);
+        xark.at("vv/elms/2", &vvc);
+        xark.at("ts1", &ts2);
+        xark.at("vts", &vtsc);
+        xark.at("tsa", &tsb);
+        xark.at("arr", &arrc);
+        C4_CHECK(g == 2 && vvc == vv[2] && memcmp(&ts2, &ts1, sizeof(ts1)) == 0);
+        C4_CHECK(vtsc.size() == vts.size() && memcmp(vtsc.data(), tsa, sizeof(tsa)) == 0);
+        C4_CHECK(memcmp(tsb, tsa, sizeof(tsa)) == 0 && memcmp(arrc, arr, sizeof(arr)) == 0);
+        // and from the start, as any other archive
+        xark.write_mode(false, "archive_indexed.bin");
+        xark("i", &ic);
+        xark("arr", &arrc);
+        C4_CHECK(ic == i && memcmp(arrc, arr, sizeof(arr)) == 0);
+
+        // the data has the plain binary format
+        c4::Archive< c4::ArchiveStreamBinaryBuffered > bark;
+        FILE *input = fopen("archive_indexed.bin", "rb");
+        bark.write_mode(false, input);
+        bark("i", &ic);
+        bark("arr", &arrc);
+        bark("ts1", &ts2);
+        bark("tsa", &tsb);
+        bark.flush();
+        fclose(input);
+        C4_CHECK(ic == i && memcmp(tsb, tsa, sizeof(tsa)) == 0);
+
+        // only the top level variables
+        output = fopen("archive_indexed.bin", "wb");
+        xark.write_mode(true, output, /*max_depth*/1);
+        xark("vv", &vv);
+        xark("tsa", &tsa);
+        xark.flush();
+        fclose(output);
+        xark.write_mode(false, "archive_indexed.bin");
+        xark.at("tsa", &tsb);
+        C4_CHECK(memcmp(tsb, tsa, sizeof(tsa)) == 0);
+    }
+
+    // only the changes from a previous archive
+    {
+        std::vector< TestStruct > vts(1000), vtsc;
+        for(size_t j = 0; j < vts.size(); ++j)
+            vts[j] = TestStruct{float(j), float(2 * j), float(3 * j)};
+        std::string s("some text"), sc;
+        int k = 10, kc = 0;
+        c4::Archive< c4::ArchiveStreamBinaryBuffered > bark;
+        FILE *output = fopen("archive_base.bin", "wb");
+        bark.write_mode(true, output);
+        bark("k", &k);
+        bark("arr", &arr);
+        bark("vts", &vts);
+        bark("s", &s);
+        bark.flush();
+        fclose(output);
+
+        ++k;
+        arr[3] = -3;
+        vts[500].y = -1.f;
+        vts[501].x = -1.f;
+        vts[900].z = -1.f;
+        c4::Archive< c4::ArchiveStreamDelta > dark;
+        output = fopen("archive_delta.bin", "wb");
+        dark.write_mode(true, output, "archive_base.bin");
+        dark("k", &k);
+        dark("arr", &arr);
+        dark("vts", &vts);
+        dark("s", &s);
+        dark.flush();
+        fclose(output);
+        C4_CHECK(read_file("archive_delta.bin").size() < 100);
+
+        FILE *input = fopen("archive_delta.bin", "rb");
+        dark.write_mode(false, input, "archive_base.bin");
+        dark("k", &kc);
+        dark("arr", &arrc);
+        dark("vts", &vtsc);
+        dark("s", &sc);
+        dark.flush();
+        fclose(input);
+        C4_CHECK(kc == k && memcmp(arrc, arr, sizeof(arr)) == 0 && sc == s);
+        C4_CHECK(vtsc.size() == vts.size() && memcmp(vtsc.data(), vts.data(), vts.size() * sizeof(TestStruct)) == 0);
+
+        // the sizes of the sequences may change, too
+        vts.resize(700);
+        s = "some more text";
+        std::string base = read_file("archive_base.bin");
+        output = fopen("archive_delta.bin", "wb");
+        dark.write_mode(true, output, base.data(), base.size());
+        dark("k", &k);
+        dark("vts", &vts);
+        dark("s", &s);
+        dark.flush();
+        fclose(output);
+        input = fopen("archive_delta.bin", "rb");
+        dark.write_mode(false, input, base.data(), base.size());
+        dark("k", &kc);
+        dark("vts", &vtsc);
+        dark("s", &sc);
+        dark.flush();
+        fclose(input);
+        C4_CHECK(kc == k && sc == s);
+        C4_CHECK(vtsc.size() == vts.size() && memcmp(vtsc.data(), vts.data(), vts.size() * sizeof(TestStruct)) == 0);
+    }
+
+    // arrays of CUSTOM_TXT classes, column by column
+    check_columns< c4::ArchiveStreamBinaryBuffered >("archive_columns.bin");
+    check_columns< c4::ArchiveStreamTextBuffered >("archive_columns.txt");
+    check_columns< c4::ArchiveStreamTagged >("archive_columns_tagged.bin");
+    check_columns< c4::ArchiveStreamVarint >("archive_columns_varint.bin");
+    check_columns< c4::ArchiveStreamBinaryEndian< c4::Endian_e::BIG > >("archive_columns_big.bin");
+    {
+        // all the x, then all the y, then all the z
+        std::string cols = read_file("archive_columns.bin");
+        C4_CHECK(cols.size() == sizeof(int) + N * sizeof(TestStruct) + N * sizeof(TestStructV2) + sizeof(int));
+        for(int j = 0; j < N; ++j)
+        {
+            float x, y, z;
+            memcpy(&x, &cols[sizeof(int) + j * sizeof(float)], sizeof(float));
+            memcpy(&y, &cols[sizeof(int) + (N + j) * sizeof(float)], sizeof(float));
+            memcpy(&z, &cols[sizeof(int) + (2 * N + j) * sizeof(float)], sizeof(float));
+            C4_CHECK(x == float(j) && y == 0.5f * j && z == -float(j));
+        }
+        c4::Archive< c4::ArchiveStreamMapped > mark;
+        mark.write_mode(false, "archive_columns.bin");
+        float zs[N];
+        mark("i", &ic);
+        mark.column< TestStruct >("tsa", "z", zs, N);
+        for(int j = 0; j < N; ++j)
+            C4_CHECK(zs[j] == -float(j));
+    }
+
     return 0;
 }
 
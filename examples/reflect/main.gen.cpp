@@ -3,33 +3,127 @@
 #include "main.gen.hpp"
 
 /** enum: auto-generated from main.hpp:8: C4_ENUM: TestEnum_e */
+// the names of the symbols of all the enums in this file
+static const char esyms_names_main_hpp[] =
+    "TE_0\0"
+    "TE_1\0"
+    "TE_2\0"
+    "TestEnumClass_e::TEC_0\0"
+    "TestEnumClass_e::TEC_1\0"
+    "TestEnumClass_e::TEC_2\0"
+    "TestEnumClass_e::TEC_3\0"
+    "TestEnumClass_e::TEC_4\0"
+    "TestEnumClass_e::TEC_5\0"
+    "TestEnumClass_e::TEC_6\0"
+    "TestEnumClass_e::TEC_7\0"
+    "TestEnumClass_e::TEC_8\0"
+    "ThisIsATest::CE_0\0"
+    "ThisIsATest::CE_1\0"
+    "ThisIsATest::CE_2\0"
+    ;
+/** enum: auto-generated from main.hpp:8: C4_ENUM: TestEnum_e */
 
 template<> const EnumSymbols< TestEnum_e > esyms()
 {
-    static const EnumSymbols< TestEnum_e >::Sym vals[] = {
-        { TE_0, "TE_0"},
-        { TE_1, "TE_1"},
-        { TE_2, "TE_2"},
+    static const EnumSymbols< TestEnum_e >::PooledSym pooled[] = {
+        { TE_0, 0, 4, 0, 3},
+        { TE_1, 5, 4, 0, 3},
+        { TE_2, 10, 4, 0, 3},
+    };
+    static const auto vals = EnumSymbols< TestEnum_e >::unpool(pooled, esyms_names_main_hpp);
+    static const uint32_t hash_disp[] = {
+        4, 0,
+    };
+    static const EnumSymbols< TestEnum_e >::NameSlot hash_slots[] = {
+        { 2, 3, 1},
+        { 1, 3, 1},
+        { 1, 0, 4},
+        { 0, 0, 0},
+        { 0, 0, 4},
+        { 0, 0, 0},
+        { 2, 0, 4},
+        { 0, 3, 1},
+    };
+    static const uint32_t bm_bits[] = {
+        1, 2,
+    };
+    static const EnumSymbols< TestEnum_e >::Index idx = {
+        0, 2, 8, hash_disp, hash_slots,
+        0, 3, nullptr,
+        nullptr,
+        0, nullptr, 2, bm_bits,
+        0, 0, nullptr, nullptr,
     };
-    EnumSymbols< TestEnum_e > r(vals);
+    EnumSymbols< TestEnum_e > r(vals, &idx);
     return r;
 }
 /** enum: auto-generated from main.hpp:15: C4_ENUM: TestEnumClass_e */
 
 template<> const EnumSymbols< TestEnumClass_e > esyms()
 {
-    static const EnumSymbols< TestEnumClass_e >::Sym vals[] = {
-        { TestEnumClass_e::TEC_0, "TestEnumClass_e::TEC_0"},
-        { TestEnumClass_e::TEC_1, "TestEnumClass_e::TEC_1"},
-        { TestEnumClass_e::TEC_2, "TestEnumClass_e::TEC_2"},
-        { TestEnumClass_e::TEC_3, "TestEnumClass_e::TEC_3"},
-        { TestEnumClass_e::TEC_4, "TestEnumClass_e::TEC_4"},
-        { TestEnumClass_e::TEC_5, "TestEnumClass_e::TEC_5"},
-        { TestEnumClass_e::TEC_6, "TestEnumClass_e::TEC_6"},
-        { TestEnumClass_e::TEC_7, "TestEnumClass_e::TEC_7"},
-        { TestEnumClass_e::TEC_8, "TestEnumClass_e::TEC_8"},
-    };
-    EnumSymbols< TestEnumClass_e > r(vals);
+    static const EnumSymbols< TestEnumClass_e >::PooledSym pooled[] = {
+        { TestEnumClass_e::TEC_0, 15, 22, 17, 21},
+        { TestEnumClass_e::TEC_1, 38, 22, 17, 21},
+        { TestEnumClass_e::TEC_2, 61, 22, 17, 21},
+        { TestEnumClass_e::TEC_3, 84, 22, 17, 21},
+        { TestEnumClass_e::TEC_4, 107, 22, 17, 21},
+        { TestEnumClass_e::TEC_5, 130, 22, 17, 21},
+        { TestEnumClass_e::TEC_6, 153, 22, 17, 21},
+        { TestEnumClass_e::TEC_7, 176, 22, 17, 21},
+        { TestEnumClass_e::TEC_8, 199, 22, 17, 21},
+    };
+    static const auto vals = EnumSymbols< TestEnumClass_e >::unpool(pooled, esyms_names_main_hpp);
+    static const uint32_t hash_disp[] = {
+        1, 8, 2, 1, 44, 10, 4, 3,
+    };
+    static const EnumSymbols< TestEnumClass_e >::NameSlot hash_slots[] = {
+        { 3, 0, 22},
+        { 0, 0, 0},
+        { 3, 21, 1},
+        { 1, 21, 1},
+        { 5, 21, 1},
+        { 4, 0, 22},
+        { 8, 0, 22},
+        { 6, 0, 22},
+        { 0, 0, 0},
+        { 5, 17, 5},
+        { 6, 21, 1},
+        { 8, 17, 5},
+        { 5, 0, 22},
+        { 4, 17, 5},
+        { 0, 0, 0},
+        { 1, 0, 22},
+        { 7, 0, 22},
+        { 0, 17, 5},
+        { 7, 17, 5},
+        { 2, 0, 22},
+        { 8, 21, 1},
+        { 1, 17, 5},
+        { 3, 17, 5},
+        { 2, 17, 5},
+        { 0, 0, 22},
+        { 7, 21, 1},
+        { 0, 0, 0},
+        { 0, 21, 1},
+        { 2, 21, 1},
+        { 4, 21, 1},
+        { 0, 0, 0},
+        { 6, 17, 5},
+    };
+    static const uint32_t bm_composites[] = {
+        7, 6, 5, 3,
+    };
+    static const uint32_t bm_bits[] = {
+        1, 2, 4, 8,
+    };
+    static const EnumSymbols< TestEnumClass_e >::Index idx = {
+        0, 8, 32, hash_disp, hash_slots,
+        0, 9, nullptr,
+        nullptr,
+        4, bm_composites, 4, bm_bits,
+        0, 0, nullptr, nullptr,
+    };
+    EnumSymbols< TestEnumClass_e > r(vals, &idx);
     return r;
 }
 
@@ -37,50 +131,78 @@ template<> const EnumSymbols< TestEnumClass_e > esyms()
 
 // TestStruct
 
-/** imgui: auto-generated from main.hpp:37: C4_CLASS: TestTpl<T> */
+/** imgui: auto-generated from main.hpp:38: C4_CLASS: TestStructV2 */
+
+// TestStructV2
+
+/** imgui: auto-generated from main.hpp:47: C4_CLASS: TestTpl<T> */
 
 // TestTpl<T>
 
-/** imgui: auto-generated from main.hpp:44: C4_CLASS: TestTpl2<T, U> */
+/** imgui: auto-generated from main.hpp:54: C4_CLASS: TestTpl2<T, U> */
 
 // TestTpl2<T, U>
 
-/** imgui: auto-generated from main.hpp:52: C4_CLASS: TestTpl3<T, U, V> */
+/** imgui: auto-generated from main.hpp:62: C4_CLASS: TestTpl3<T, U, V> */
 
 // TestTpl3<T, U, V>
 
-/** imgui: auto-generated from main.hpp:61: C4_CLASS: TestTpl4<T, U, V, N> */
+/** imgui: auto-generated from main.hpp:71: C4_CLASS: TestTpl4<T, U, V, N> */
 
 // TestTpl4<T, U, V, N>
 
-/** imgui: auto-generated from main.hpp:70: C4_CLASS: TestTpl51<T, U, V, N, AAA> */
+/** imgui: auto-generated from main.hpp:80: C4_CLASS: TestTpl51<T, U, V, N, AAA> */
 
 // TestTpl51<T, U, V, N, AAA>
 
-/** imgui: auto-generated from main.hpp:80: C4_CLASS: TestTpl52<T, U, V, N, AAA> */
+/** imgui: auto-generated from main.hpp:90: C4_CLASS: TestTpl52<T, U, V, N, AAA> */
 
 // TestTpl52<T, U, V, N, AAA>
 
-/** imgui: auto-generated from main.hpp:90: C4_CLASS: TestTpl53<T, U, V, N, AAA> */
+/** imgui: auto-generated from main.hpp:100: C4_CLASS: TestTpl53<T, U, V, N, AAA> */
 
 // TestTpl53<T, U, V, N, AAA>
 
-/** imgui: auto-generated from main.hpp:100: C4_CLASS: TestTpl54<T, U, V, N, AAA> */
+/** imgui: auto-generated from main.hpp:110: C4_CLASS: TestTpl54<T, U, V, N, AAA> */
 
 // TestTpl54<T, U, V, N, AAA>
 
-/** imgui: auto-generated from main.hpp:110: C4_CLASS: ThisIsATest */
+/** imgui: auto-generated from main.hpp:120: C4_CLASS: ThisIsATest */
 
 // ThisIsATest
-/** enum: auto-generated from main.hpp:113: C4_ENUM: ThisIsATest::TTestEnum_e */
+/** enum: auto-generated from main.hpp:123: C4_ENUM: ThisIsATest::TTestEnum_e */
 
 template<> const EnumSymbols< ThisIsATest::TTestEnum_e > esyms()
 {
-    static const EnumSymbols< ThisIsATest::TTestEnum_e >::Sym vals[] = {
-        { ThisIsATest::CE_0, "ThisIsATest::CE_0"},
-        { ThisIsATest::CE_1, "ThisIsATest::CE_1"},
-        { ThisIsATest::CE_2, "ThisIsATest::CE_2"},
+    static const EnumSymbols< ThisIsATest::TTestEnum_e >::PooledSym pooled[] = {
+        { ThisIsATest::CE_0, 222, 17, 0, 16},
+        { ThisIsATest::CE_1, 240, 17, 0, 16},
+        { ThisIsATest::CE_2, 258, 17, 0, 16},
+    };
+    static const auto vals = EnumSymbols< ThisIsATest::TTestEnum_e >::unpool(pooled, esyms_names_main_hpp);
+    static const uint32_t hash_disp[] = {
+        1, 0,
+    };
+    static const EnumSymbols< ThisIsATest::TTestEnum_e >::NameSlot hash_slots[] = {
+        { 2, 16, 1},
+        { 1, 16, 1},
+        { 0, 0, 17},
+        { 2, 0, 17},
+        { 0, 0, 0},
+        { 1, 0, 17},
+        { 0, 0, 0},
+        { 0, 16, 1},
+    };
+    static const uint32_t bm_bits[] = {
+        1, 2,
+    };
+    static const EnumSymbols< ThisIsATest::TTestEnum_e >::Index idx = {
+        0, 2, 8, hash_disp, hash_slots,
+        0, 3, nullptr,
+        nullptr,
+        0, nullptr, 2, bm_bits,
+        0, 0, nullptr, nullptr,
     };
-    EnumSymbols< ThisIsATest::TTestEnum_e > r(vals);
+    EnumSymbols< ThisIsATest::TTestEnum_e > r(vals, &idx);
     return r;
 }
\ No newline at end of file
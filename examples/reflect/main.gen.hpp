@@ -5,6 +5,7 @@
 
 #include "main.hpp"
 
+
 /** enum: auto-generated from main.hpp:8: C4_ENUM: TestEnum_e */
 #include "enum.hpp"
 template<> const EnumSymbols< TestEnum_e > esyms();
@@ -13,6 +14,23 @@ template<> inline size_t eoffs_pfx< TestEnum_e >()
     // same as strlen("TE_")
     return 3;
 }
+template<> constexpr size_t esize< TestEnum_e >()
+{
+    return 3;
+}
+template<> inline size_t eindex< TestEnum_e >(TestEnum_e v)
+{
+    // the values are contiguous
+    using U = std::make_unsigned< std::underlying_type< TestEnum_e >::type >::type;
+    U i = static_cast< U >(static_cast< U >(v) - static_cast< U >(0ull));
+    return i < 3 ? i : 3;
+}
+template<> inline TestEnum_e evalue< TestEnum_e >(size_t i)
+{
+    using U = std::make_unsigned< std::underlying_type< TestEnum_e >::type >::type;
+    C4_XASSERT(i < 3);
+    return static_cast< TestEnum_e >(static_cast< U >(static_cast< U >(0ull) + static_cast< U >(i)));
+}
 
 /** enum: auto-generated from main.hpp:15: C4_ENUM: TestEnumClass_e */
 #include "enum.hpp"
@@ -27,17 +45,65 @@ template<> inline size_t eoffs_pfx< TestEnumClass_e >()
     // same as strlen("TestEnumClass_e::TEC_")
     return 21;
 }
+template<> constexpr size_t esize< TestEnumClass_e >()
+{
+    return 9;
+}
+template<> inline size_t eindex< TestEnumClass_e >(TestEnumClass_e v)
+{
+    // the values are contiguous
+    using U = std::make_unsigned< std::underlying_type< TestEnumClass_e >::type >::type;
+    U i = static_cast< U >(static_cast< U >(v) - static_cast< U >(0ull));
+    return i < 9 ? i : 9;
+}
+template<> inline TestEnumClass_e evalue< TestEnumClass_e >(size_t i)
+{
+    using U = std::make_unsigned< std::underlying_type< TestEnumClass_e >::type >::type;
+    C4_XASSERT(i < 9);
+    return static_cast< TestEnumClass_e >(static_cast< U >(static_cast< U >(0ull) + static_cast< U >(i)));
+}
 
 /** serialize: auto-generated from main.hpp:30: C4_CLASS: TestStruct */
 #include "serialize.hpp"
 namespace c4 {
 template <>
 struct serialize_category< TestStruct >
-{ enum : int { value = (int)SerializeCategory_e::METHOD }; };
+{ enum : int { value = (int)SerializeCategory_e::CUSTOM_TXT }; };
+template <>
+struct serialize_schema< TestStruct >
+{
+    enum : size_t { num_fields = 3 };
+    static SchemaField const* fields()
+    {
+        static const SchemaField f[] = {
+            schema_field< float >(794621484u, offsetof(TestStruct, x)), // x
+            schema_field< float >(804166841u, offsetof(TestStruct, y)), // y
+            schema_field< float >(228143771u, offsetof(TestStruct, z)), // z
+        };
+        return f;
+    }
+};
+template <>
+struct serialize_columns< TestStruct >
+{
+    enum : bool { value = true };
+    template< class Walk >
+    static void walk(Walk &w)
+    {
+        w.template column< float >("x", offsetof(TestStruct, x));
+        w.template column< float >("y", offsetof(TestStruct, y));
+        w.template column< float >("z", offsetof(TestStruct, z));
+    }
+};
 } // namespace c4
 template <class Stream>
 void TestStruct::serialize(c4::Archive< Stream > &a, const char *name)
 {
+    // binary archives copy the whole object with memcpy()
+    static_assert(std::is_trivially_copyable< TestStruct >::value
+                  && std::is_standard_layout< TestStruct >::value
+                  && sizeof(TestStruct) == sizeof(x) + sizeof(y) + sizeof(z),
+                  "TestStruct: the layout does not match the generated code; regenerate it");
     c4::serialize< float >(a, "x", &this->x);
     c4::serialize< float >(a, "y", &this->y);
     c4::serialize< float >(a, "z", &this->z);
@@ -45,7 +111,55 @@ void TestStruct::serialize(c4::Archive< Stream > &a, const char *name)
 /** imgui: auto-generated from main.hpp:30: C4_CLASS: TestStruct */
 
 // TestStruct
-/** serialize: auto-generated from main.hpp:37: C4_CLASS: TestTpl<T> */
+/** serialize: auto-generated from main.hpp:38: C4_CLASS: TestStructV2 */
+#include "serialize.hpp"
+namespace c4 {
+template <>
+struct serialize_category< TestStructV2 >
+{ enum : int { value = (int)SerializeCategory_e::CUSTOM_TXT }; };
+template <>
+struct serialize_schema< TestStructV2 >
+{
+    enum : size_t { num_fields = 3 };
+    static SchemaField const* fields()
+    {
+        static const SchemaField f[] = {
+            schema_field< double >(228143771u, offsetof(TestStructV2, z)), // z
+            schema_field< float >(794621484u, offsetof(TestStructV2, x)), // x
+            schema_field< int32_t >(1701362178u, offsetof(TestStructV2, w)), // w
+        };
+        return f;
+    }
+};
+template <>
+struct serialize_columns< TestStructV2 >
+{
+    enum : bool { value = true };
+    template< class Walk >
+    static void walk(Walk &w)
+    {
+        w.template column< double >("z", offsetof(TestStructV2, z));
+        w.template column< float >("x", offsetof(TestStructV2, x));
+        w.template column< int32_t >("w", offsetof(TestStructV2, w));
+    }
+};
+} // namespace c4
+template <class Stream>
+void TestStructV2::serialize(c4::Archive< Stream > &a, const char *name)
+{
+    // binary archives copy the whole object with memcpy()
+    static_assert(std::is_trivially_copyable< TestStructV2 >::value
+                  && std::is_standard_layout< TestStructV2 >::value
+                  && sizeof(TestStructV2) == sizeof(z) + sizeof(x) + sizeof(w),
+                  "TestStructV2: the layout does not match the generated code; regenerate it");
+    c4::serialize< double >(a, "z", &this->z);
+    c4::serialize< float >(a, "x", &this->x);
+    c4::serialize< int32_t >(a, "w", &this->w);
+}
+/** imgui: auto-generated from main.hpp:38: C4_CLASS: TestStructV2 */
+
+// TestStructV2
+/** serialize: auto-generated from main.hpp:47: C4_CLASS: TestTpl<T> */
 #include "serialize.hpp"
 namespace c4 {
 template <class T>
@@ -61,10 +175,10 @@ void TestTpl<T>::serialize(c4::Archive< Stream > &a, const char *name)
     c4::serialize< T >(a, "b", &this->b);
     c4::serialize< T >(a, "a", &this->a);
 }
-/** imgui: auto-generated from main.hpp:37: C4_CLASS: TestTpl<T> */
+/** imgui: auto-generated from main.hpp:47: C4_CLASS: TestTpl<T> */
 
 // TestTpl<T>
-/** serialize: auto-generated from main.hpp:44: C4_CLASS: TestTpl2<T, U> */
+/** serialize: auto-generated from main.hpp:54: C4_CLASS: TestTpl2<T, U> */
 #include "serialize.hpp"
 namespace c4 {
 template <class T, class U>
@@ -78,10 +192,10 @@ void TestTpl2<T, U>::serialize(c4::Archive< Stream > &a, const char *name)
     c4::serialize< T >(a, "x", &this->x);
     c4::serialize< U >(a, "y", &this->y);
 }
-/** imgui: auto-generated from main.hpp:44: C4_CLASS: TestTpl2<T, U> */
+/** imgui: auto-generated from main.hpp:54: C4_CLASS: TestTpl2<T, U> */
 
 // TestTpl2<T, U>
-/** serialize: auto-generated from main.hpp:52: C4_CLASS: TestTpl3<T, U, V> */
+/** serialize: auto-generated from main.hpp:62: C4_CLASS: TestTpl3<T, U, V> */
 #include "serialize.hpp"
 namespace c4 {
 template <class T, class U, class V>
@@ -96,10 +210,10 @@ void TestTpl3<T, U, V>::serialize(c4::Archive< Stream > &a, const char *name)
     c4::serialize< U >(a, "y", &this->y);
     c4::serialize< V >(a, "z", &this->z);
 }
-/** imgui: auto-generated from main.hpp:52: C4_CLASS: TestTpl3<T, U, V> */
+/** imgui: auto-generated from main.hpp:62: C4_CLASS: TestTpl3<T, U, V> */
 
 // TestTpl3<T, U, V>
-/** serialize: auto-generated from main.hpp:61: C4_CLASS: TestTpl4<T, U, V, N> */
+/** serialize: auto-generated from main.hpp:71: C4_CLASS: TestTpl4<T, U, V, N> */
 #include "serialize.hpp"
 namespace c4 {
 template <class T, class U, class V, int N>
@@ -110,14 +224,14 @@ template <class T, class U, class V, int N>
 template <class Stream>
 void TestTpl4<T, U, V, N>::serialize(c4::Archive< Stream > &a, const char *name)
 {
-    c4::serialize< T [N] >(a, "x", &this->x);
-    c4::serialize< U [N] >(a, "y", &this->y);
-    c4::serialize< V [N] >(a, "z", &this->z);
+    c4::serialize< T[N] >(a, "x", &this->x);
+    c4::serialize< U[N] >(a, "y", &this->y);
+    c4::serialize< V[N] >(a, "z", &this->z);
 }
-/** imgui: auto-generated from main.hpp:61: C4_CLASS: TestTpl4<T, U, V, N> */
+/** imgui: auto-generated from main.hpp:71: C4_CLASS: TestTpl4<T, U, V, N> */
 
 // TestTpl4<T, U, V, N>
-/** serialize: auto-generated from main.hpp:70: C4_CLASS: TestTpl51<T, U, V, N, AAA> */
+/** serialize: auto-generated from main.hpp:80: C4_CLASS: TestTpl51<T, U, V, N, AAA> */
 #include "serialize.hpp"
 namespace c4 {
 template <class T, class U, class V, int N, template<class> class  AAA>
@@ -128,15 +242,15 @@ template <class T, class U, class V, int N, template<class> class  AAA>
 template <class Stream>
 void TestTpl51<T, U, V, N, AAA>::serialize(c4::Archive< Stream > &a, const char *name)
 {
-    c4::serialize< T [N] >(a, "x", &this->x);
-    c4::serialize< U [N] >(a, "y", &this->y);
-    c4::serialize< V [N] >(a, "z", &this->z);
+    c4::serialize< T[N] >(a, "x", &this->x);
+    c4::serialize< U[N] >(a, "y", &this->y);
+    c4::serialize< V[N] >(a, "z", &this->z);
     c4::serialize< AAA<T> >(a, "w", &this->w);
 }
-/** imgui: auto-generated from main.hpp:70: C4_CLASS: TestTpl51<T, U, V, N, AAA> */
+/** imgui: auto-generated from main.hpp:80: C4_CLASS: TestTpl51<T, U, V, N, AAA> */
 
 // TestTpl51<T, U, V, N, AAA>
-/** serialize: auto-generated from main.hpp:80: C4_CLASS: TestTpl52<T, U, V, N, AAA> */
+/** serialize: auto-generated from main.hpp:90: C4_CLASS: TestTpl52<T, U, V, N, AAA> */
 #include "serialize.hpp"
 namespace c4 {
 template <class T, class U, class V, int N, template<class, class> class  AAA>
@@ -147,15 +261,15 @@ template <class T, class U, class V, int N, template<class, class> class  AAA>
 template <class Stream>
 void TestTpl52<T, U, V, N, AAA>::serialize(c4::Archive< Stream > &a, const char *name)
 {
-    c4::serialize< T [N] >(a, "x", &this->x);
-    c4::serialize< U [N] >(a, "y", &this->y);
-    c4::serialize< V [N] >(a, "z", &this->z);
+    c4::serialize< T[N] >(a, "x", &this->x);
+    c4::serialize< U[N] >(a, "y", &this->y);
+    c4::serialize< V[N] >(a, "z", &this->z);
     c4::serialize< AAA<T, U> >(a, "w", &this->w);
 }
-/** imgui: auto-generated from main.hpp:80: C4_CLASS: TestTpl52<T, U, V, N, AAA> */
+/** imgui: auto-generated from main.hpp:90: C4_CLASS: TestTpl52<T, U, V, N, AAA> */
 
 // TestTpl52<T, U, V, N, AAA>
-/** serialize: auto-generated from main.hpp:90: C4_CLASS: TestTpl53<T, U, V, N, AAA> */
+/** serialize: auto-generated from main.hpp:100: C4_CLASS: TestTpl53<T, U, V, N, AAA> */
 #include "serialize.hpp"
 namespace c4 {
 template <class T, class U, class V, int N, template<class, class, class> class  AAA>
@@ -166,15 +280,15 @@ template <class T, class U, class V, int N, template<class, class, class> class
 template <class Stream>
 void TestTpl53<T, U, V, N, AAA>::serialize(c4::Archive< Stream > &a, const char *name)
 {
-    c4::serialize< T [N] >(a, "x", &this->x);
-    c4::serialize< U [N] >(a, "y", &this->y);
-    c4::serialize< V [N] >(a, "z", &this->z);
+    c4::serialize< T[N] >(a, "x", &this->x);
+    c4::serialize< U[N] >(a, "y", &this->y);
+    c4::serialize< V[N] >(a, "z", &this->z);
     c4::serialize< AAA<T, U, V> >(a, "w", &this->w);
 }
-/** imgui: auto-generated from main.hpp:90: C4_CLASS: TestTpl53<T, U, V, N, AAA> */
+/** imgui: auto-generated from main.hpp:100: C4_CLASS: TestTpl53<T, U, V, N, AAA> */
 
 // TestTpl53<T, U, V, N, AAA>
-/** serialize: auto-generated from main.hpp:100: C4_CLASS: TestTpl54<T, U, V, N, AAA> */
+/** serialize: auto-generated from main.hpp:110: C4_CLASS: TestTpl54<T, U, V, N, AAA> */
 #include "serialize.hpp"
 namespace c4 {
 template <class T, class U, class V, int N, template<class, class, class, int> class  AAA>
@@ -185,15 +299,15 @@ template <class T, class U, class V, int N, template<class, class, class, int> c
 template <class Stream>
 void TestTpl54<T, U, V, N, AAA>::serialize(c4::Archive< Stream > &a, const char *name)
 {
-    c4::serialize< T [N] >(a, "x", &this->x);
-    c4::serialize< U [N] >(a, "y", &this->y);
-    c4::serialize< V [N] >(a, "z", &this->z);
+    c4::serialize< T[N] >(a, "x", &this->x);
+    c4::serialize< U[N] >(a, "y", &this->y);
+    c4::serialize< V[N] >(a, "z", &this->z);
     c4::serialize< AAA<T, U, V, N> >(a, "w", &this->w);
 }
-/** imgui: auto-generated from main.hpp:100: C4_CLASS: TestTpl54<T, U, V, N, AAA> */
+/** imgui: auto-generated from main.hpp:110: C4_CLASS: TestTpl54<T, U, V, N, AAA> */
 
 // TestTpl54<T, U, V, N, AAA>
-/** serialize: auto-generated from main.hpp:110: C4_CLASS: ThisIsATest */
+/** serialize: auto-generated from main.hpp:120: C4_CLASS: ThisIsATest */
 #include "serialize.hpp"
 namespace c4 {
 template <>
@@ -213,10 +327,10 @@ void ThisIsATest::serialize(c4::Archive< Stream > &a, const char *name)
     c4::serialize< TestStruct >(a, "ts", &this->ts);
     c4::serialize< TestTpl<uint32_t> >(a, "ttpl", &this->ttpl);
 }
-/** imgui: auto-generated from main.hpp:110: C4_CLASS: ThisIsATest */
+/** imgui: auto-generated from main.hpp:120: C4_CLASS: ThisIsATest */
 
 // ThisIsATest
-/** enum: auto-generated from main.hpp:113: C4_ENUM: ThisIsATest::TTestEnum_e */
+/** enum: auto-generated from main.hpp:123: C4_ENUM: ThisIsATest::TTestEnum_e */
 #include "enum.hpp"
 template<> const EnumSymbols< ThisIsATest::TTestEnum_e > esyms();
 template<> inline size_t eoffs_pfx< ThisIsATest::TTestEnum_e >()
@@ -224,6 +338,26 @@ template<> inline size_t eoffs_pfx< ThisIsATest::TTestEnum_e >()
     // same as strlen("ThisIsATest::CE_")
     return 16;
 }
+template<> constexpr size_t esize< ThisIsATest::TTestEnum_e >()
+{
+    return 3;
+}
+template<> inline size_t eindex< ThisIsATest::TTestEnum_e >(ThisIsATest::TTestEnum_e v)
+{
+    // the values are contiguous
+    using U = std::make_unsigned< std::underlying_type< ThisIsATest::TTestEnum_e >::type >::type;
+    U i = static_cast< U >(static_cast< U >(v) - static_cast< U >(0ull));
+    return i < 3 ? i : 3;
+}
+template<> inline ThisIsATest::TTestEnum_e evalue< ThisIsATest::TTestEnum_e >(size_t i)
+{
+    using U = std::make_unsigned< std::underlying_type< ThisIsATest::TTestEnum_e >::type >::type;
+    C4_XASSERT(i < 3);
+    return static_cast< ThisIsATest::TTestEnum_e >(static_cast< U >(static_cast< U >(0ull) + static_cast< U >(i)));
+}
+
+
+
 
 
 
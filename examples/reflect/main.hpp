@@ -31,6 +31,16 @@ struct TestStruct
     float x, y, z;
     C4_DECLARE_SERIALIZE_METHOD()
 };
+/** a later version of TestStruct: y was removed, z became a double and
+ * w was added */
+struct TestStructV2
+{
+    C4_CLASS()
+    double z;
+    float x;
+    int32_t w;
+    C4_DECLARE_SERIALIZE_METHOD()
+};
 template< class T >
 struct TestTpl
 {
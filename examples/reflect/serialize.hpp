@@ -6,6 +6,52 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <memory>
+#include <limits>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <errno.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#   if __has_include(<charconv>)
+#       include <charconv>
+#       if defined(__cpp_lib_to_chars)
+#           define C4_SERIALIZE_CHARCONV
+#       endif
+#   endif
+#endif
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#   define C4_SERIALIZE_BIG_ENDIAN
+#endif
+
+#if defined(__SSSE3__)
+#   define C4_SERIALIZE_SSSE3
+#   include <tmmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#   define C4_SERIALIZE_MMAP
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#endif
+
+/** for the slow paths of the buffers, so that the fast paths are small
+ * enough to be inlined at each variable */
+#if defined(_MSC_VER)
+#   define C4_SERIALIZE_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__)
+#   define C4_SERIALIZE_NOINLINE __attribute__((noinline))
+#else
+#   define C4_SERIALIZE_NOINLINE
+#endif
 
 #include "util.hpp"
 
@@ -42,6 +88,8 @@ private:
  *-----------------+-------------------------+---------------------------------
  * METHOD          |  N * (var->serialize()) |     N * (var->serialize())
  *-----------------+-------------------------+---------------------------------
+ * CUSTOM_TXT      |     1 * memcpy()        |     N * (var->serialize())
+ *-----------------+-------------------------+---------------------------------
  */
 enum class SerializeCategory_e : int
 {
@@ -52,10 +100,12 @@ enum class SerializeCategory_e : int
     CUSTOM,
     /** for classes that provide a member serialize() method. */
     METHOD,
-    /** mix between NATIVE and CUSTOM: memcpy() for binary archives,
-     * but uses specialization of c4::serialize() for text archives
-     * @todo implement this*/
-    // CUSTOM_TXT,
+    /** mix between NATIVE and METHOD, for classes with a member
+     * serialize() method whose bytes are all their members, such as
+     * pod structs without padding: memcpy() for binary archives, but
+     * member by member for text archives. The class generator chooses
+     * this for the classes where it applies. */
+    CUSTOM_TXT,
 
     //inline bool operator== (int v) const { return static_cast< SerializeCategory_e >(v) == *this; }
 };
@@ -78,6 +128,98 @@ struct serialize_category< T[N] >
     enum : int { value = serialize_category< T >::value };
 };
 
+//-----------------------------------------------------------------------------
+
+/** the type codes of the values in archives with field tags.
+ * @see ArchiveStreamTagged */
+enum TagCode_e : uint8_t
+{
+    /** nested tagged fields */
+    TAG_OBJECT = 0x00,
+    /** integers and floating point values: the kind is or'ed with the
+     * log2 of the size in bytes */
+    TAG_SINT = 0x10,
+    TAG_UINT = 0x20,
+    TAG_FLOAT = 0x30,
+    /** the bytes of a type which is none of the others */
+    TAG_RAW = 0x40,
+    /** the bytes of a CUSTOM_TXT class, with the index of its schema */
+    TAG_SCHEMA = 0x50,
+    /** flag for sequences of values of the other types */
+    TAG_SEQ = 0x80,
+};
+
+namespace detail {
+constexpr uint8_t tag_log2(size_t sz) { return sz <= 1 ? 0 : uint8_t(1 + tag_log2(sz / 2)); }
+template< class T, bool = std::is_enum< T >::value >
+struct tag_arith { using type = T; };
+template< class T >
+struct tag_arith< T, true > { using type = typename std::underlying_type< T >::type; };
+
+inline bool tag_is_scalar(uint8_t code)
+{
+    uint8_t kind = code & 0xf0;
+    return (kind == TAG_SINT || kind == TAG_UINT || kind == TAG_FLOAT) && (code & 0x0f) <= 3;
+}
+inline size_t tag_scalar_size(uint8_t code)
+{
+    return size_t(1) << (code & 0x0f);
+}
+} // namespace detail
+
+/** get the type code of T. Enums have the code of their underlying type. */
+template< class T >
+constexpr uint8_t tag_code()
+{
+    using A = typename detail::tag_arith< T >::type;
+    return std::is_floating_point< A >::value ? uint8_t(TAG_FLOAT | detail::tag_log2(sizeof(A)))
+        : std::is_integral< A >::value ? uint8_t((std::is_signed< A >::value ? TAG_SINT : TAG_UINT) | detail::tag_log2(sizeof(A)))
+        : uint8_t(TAG_RAW);
+}
+
+/** a field in the schema of a class */
+struct SchemaField
+{
+    uint32_t id;      //< the hash of the field name. @see detail::field_id()
+    uint32_t offset;  //< the offset of the field in the class, in bytes
+    uint8_t  code;    //< the type code of the elements of the field
+    uint32_t count;   //< the number of elements: the extent of C arrays, or 1
+};
+
+template< class T >
+constexpr SchemaField schema_field(uint32_t id, uint32_t offset)
+{
+    return SchemaField{id, offset, tag_code< typename std::remove_all_extents< T >::type >(),
+                       uint32_t(sizeof(T) / sizeof(typename std::remove_all_extents< T >::type))};
+}
+
+/** the layout of a CUSTOM_TXT class, which lets archives with field tags
+ * copy it with memcpy() when the layout where it was written is the same,
+ * and field by field otherwise. The class generator specializes this for
+ * the classes it makes CUSTOM_TXT. @see ArchiveStreamTagged */
+template< class T >
+struct serialize_schema
+{
+    enum : size_t { num_fields = 0 };
+    static SchemaField const* fields() { return nullptr; }
+};
+
+/** the columns of a CUSTOM_TXT class, for Archive::columns(): walk()
+ * calls w.template column< M >(name, offset) for each member, in order,
+ * where M is the type of the member. The class generator specializes
+ * this for the classes it makes CUSTOM_TXT. */
+template< class T >
+struct serialize_columns
+{
+    enum : bool { value = false };
+    template< class Walk >
+    static void walk(Walk &w) {}
+};
+
+namespace detail {
+template< class Stream, class T > struct ColumnWalk;
+} // namespace detail
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -104,6 +246,18 @@ public:
     }
     bool write_mode() const { return m_stream.write_mode(); }
 
+    /** write out (or give back) the data buffered by the stream */
+    void flush() { m_stream.flush(); }
+
+    /** start writing out the data buffered by the stream, without waiting
+     * for it. Only for asynchronous streams.
+     * @see ArchiveStreamBinaryAsync::finish() */
+    template< class S = Stream >
+    auto finish() -> decltype(std::declval< S& >().finish())
+    {
+        return m_stream.finish();
+    }
+
 public:
 
     template< class T >
@@ -117,7 +271,9 @@ public:
     _c4sfinae(void, CUSTOM) operator()(const char* name, T *var)
     {
         push(name);
-        c4::serialize(*this, name, var);
+        // unqualified, so that argument-dependent lookup also finds the
+        // overloads declared after this (eg in serialize_std.hpp)
+        serialize(*this, name, var);
         pop(name);
     }
     template< class T >
@@ -128,6 +284,14 @@ public:
         pop(name);
     }
 
+    template< class T >
+    _c4sfinae(void, CUSTOM_TXT) operator()(const char* name, T *var)
+    {
+        push(name);
+        _custom_txt(name, var, std::integral_constant< bool, Stream::is_binary >());
+        pop(name);
+    }
+
     template< class T, size_t N >
     void operator()(const char *name, T (*var)[N])
     {
@@ -147,7 +311,9 @@ public:
         push_seq(name, num);
         for(size_t i = 0; i < num; ++i)
         {
-            c4::serialize(*this, name, var + i);
+            push_elm(name, i);
+            serialize(*this, name, var + i);
+            pop_elm(name, i);
         }
         pop_seq(name, num);
     }
@@ -157,15 +323,155 @@ public:
         push_seq(name, num);
         for(size_t i = 0; i < num; ++i)
         {
+            push_elm(name, i);
             (var + i)->serialize(*this, name);
+            pop_elm(name, i);
         }
         pop_seq(name, num);
     }
+    template< class T >
+    _c4sfinae(void, CUSTOM_TXT) operator()(const char* name, T *var, size_t num)
+    {
+        push_seq(name, num);
+        _custom_txt(name, var, num, std::integral_constant< bool, Stream::is_binary >());
+        pop_seq(name, num);
+    }
+
+    /** get a pointer to a sequence of num NATIVE (or CUSTOM_TXT) values,
+     * in place in the data of the stream, instead of copying them to a
+     * variable. When the data is not aligned for T, it is copied to copy
+     * (if given) and copy is returned. Only for streams reading from
+     * memory.
+     * @see ArchiveStreamMapped */
+    template< class T >
+    T const* view(const char* name, size_t num, T *copy = nullptr)
+    {
+        static_assert(serialize_category< T >::value == (int)SerializeCategory_e::NATIVE
+                      || serialize_category< T >::value == (int)SerializeCategory_e::CUSTOM_TXT,
+                      "only for NATIVE or CUSTOM_TXT types");
+        push_seq(name, num);
+        T const* p = m_stream.view(num, copy);
+        pop_seq(name, num);
+        return p;
+    }
+
+    /** serialize num objects of a CUSTOM_TXT class column by column: the
+     * values of the first member of all the objects, then the values of
+     * the second member, and so on. So each column is a sequence of a
+     * NATIVE type, which goes in bulk, and a single column can be read
+     * with column(). The columns are written as an object named name
+     * whose fields are the sequences named as the members.
+     * @see serialize_columns */
+    template< class T >
+    void columns(const char* name, T *var, size_t num)
+    {
+        static_assert(serialize_columns< T >::value, "only for the CUSTOM_TXT classes of the class generator");
+        detail::ColumnWalk< Stream, T > w{this, var, num, nullptr, nullptr, 0, 0, false};
+        push(name);
+        serialize_columns< T >::walk(w);
+        pop(name);
+    }
+
+    /** read a single column of num objects of T written with columns():
+     * the values of the member named member go to out, which must be of
+     * the type of the member. The other columns are skipped; if the
+     * stream can not skip, they are read and thrown away.
+     * @see skip() */
+    template< class T, class M >
+    void column(const char* name, const char* member, M *out, size_t num)
+    {
+        static_assert(serialize_columns< T >::value, "only for the CUSTOM_TXT classes of the class generator");
+        using E = typename std::remove_all_extents< M >::type;
+        C4_CHECK_MSG( ! write_mode(), "column() is only for reading");
+        detail::ColumnWalk< Stream, T > w{this, nullptr, num, member, out, sizeof(M), tag_code< E >(), false};
+        push(name);
+        serialize_columns< T >::walk(w);
+        pop(name);
+        C4_CHECK_MSG(w.found, "%s: no column %s", name, member);
+    }
+
+    /** when reading, go past a sequence of num values of the NATIVE type
+     * T. Streams with fixed size values jump over the data; the others
+     * read it and throw it away. */
+    template< class T >
+    void skip(const char* name, size_t num)
+    {
+        static_assert(serialize_category< T >::value == (int)SerializeCategory_e::NATIVE, "only for NATIVE types");
+        C4_CHECK_MSG( ! write_mode(), "skip() is only for reading");
+        _skip< T >(name, num, 0);
+    }
+
+    /** read only the variable at a name path (eg "a/b/c"), without
+     * reading what comes before it. Only for streams with an index.
+     * @see ArchiveStreamIndexed */
+    template< class T >
+    void at(const char* path, T *var)
+    {
+        C4_CHECK_MSG(m_stream.seek(path), "%s: not in the archive", path);
+        (*this)(_basename(path), var);
+    }
+    template< class T >
+    void at(const char* path, T *var, size_t num)
+    {
+        C4_CHECK_MSG(m_stream.seek(path), "%s: not in the archive", path);
+        (*this)(_basename(path), var, num);
+    }
 
     void push(const char* name) { m_stream.push_var(name); }
     void pop(const char* name) { m_stream.pop_var(name); }
     void push_seq(const char* name, size_t num) { m_stream.push_seq(name, num); }
     void pop_seq(const char* name, size_t num) { m_stream.pop_seq(name, num); }
+    /** delimit the i-th element of a sequence of non-NATIVE values */
+    void push_elm(const char* name, size_t i) { m_stream.push_elm(name, i); }
+    void pop_elm(const char* name, size_t i) { m_stream.pop_elm(name, i); }
+
+private:
+
+    static const char* _basename(const char* path)
+    {
+        const char *slash = strrchr(path, '/');
+        return slash ? slash + 1 : path;
+    }
+
+    template< class T, class S = Stream >
+    auto _skip(const char* name, size_t num, int) -> decltype(std::declval< S& >().skip(size_t()))
+    {
+        push_seq(name, num);
+        m_stream.skip(num * sizeof(T));
+        pop_seq(name, num);
+    }
+    template< class T >
+    void _skip(const char* name, size_t num, long)
+    {
+        std::unique_ptr< T[] > scratch(new T[num ? num : 1]);
+        (*this)(name, scratch.get(), num);
+    }
+
+    template< class T >
+    void _custom_txt(const char* name, T *var, std::true_type /*is_binary*/)
+    {
+        m_stream(var);
+    }
+    template< class T >
+    void _custom_txt(const char* name, T *var, std::false_type /*is_binary*/)
+    {
+        var->serialize(*this, name);
+    }
+    template< class T >
+    void _custom_txt(const char* name, T *var, size_t num, std::true_type /*is_binary*/)
+    {
+        m_stream(var, num);
+    }
+    template< class T >
+    void _custom_txt(const char* name, T *var, size_t num, std::false_type /*is_binary*/)
+    {
+        for(size_t i = 0; i < num; ++i)
+        {
+            push_elm(name, i);
+            (var + i)->serialize(*this, name);
+            pop_elm(name, i);
+        }
+    }
 
 private:
 
@@ -175,6 +481,61 @@ private:
 
 #undef _c4sfinae
 
+namespace detail {
+
+/** the walk over the columns of num objects of T, for Archive::columns()
+ * and Archive::column(). Each column is gathered to (or scattered from)
+ * a contiguous array; C arrays are flattened to their elements. */
+template< class Stream, class T >
+struct ColumnWalk
+{
+    Archive< Stream > *a;
+    T *var;              //< the objects, or null when reading one column
+    size_t num;
+    const char *member;  //< the column to read, or null for all of them
+    void *out;           //< where to read the column
+    size_t out_size;     //< the size of the type of out
+    uint8_t out_code;    //< the type code of the elements of out
+    bool found;
+
+    template< class M >
+    void column(const char *name, size_t offset)
+    {
+        using E = typename std::remove_all_extents< M >::type;
+        const size_t k = sizeof(M) / sizeof(E);
+        if(member)
+        {
+            if(strcmp(name, member) != 0)
+            {
+                a->template skip< E >(name, num * k);
+                return;
+            }
+            C4_CHECK_MSG(out_size == sizeof(M) && out_code == tag_code< E >(),
+                         "column %s: wrong type", name);
+            found = true;
+            (*a)(name, static_cast< E* >(out), num * k);
+            return;
+        }
+        const size_t n = num * k;
+        std::unique_ptr< E[] > col(new E[n ? n : 1]);
+        char *base = reinterpret_cast< char* >(var) + offset;
+        if(a->write_mode())
+        {
+            for(size_t i = 0; i < num; ++i)
+                memcpy(col.get() + i * k, base + i * sizeof(T), sizeof(M));
+            (*a)(name, col.get(), n);
+        }
+        else
+        {
+            (*a)(name, col.get(), n);
+            for(size_t i = 0; i < num; ++i)
+                memcpy(base + i * sizeof(T), col.get() + i * k, sizeof(M));
+        }
+    }
+};
+
+} // namespace detail
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -203,6 +564,8 @@ void serialize(Archive< Stream > &a, const char* name, T (*var)[N])
 struct ArchiveStreamText
 {
 
+    enum : bool { is_binary = false };
+
     bool writing = true;
     int level = 0;
     FILE* file = nullptr;
@@ -225,6 +588,12 @@ struct ArchiveStreamText
         }
     }
 
+    void flush()
+    {
+        if(writing && file)
+            fflush(file);
+    }
+
     void push_var(const char *name)
     {
         if(writing)
@@ -330,6 +699,14 @@ struct ArchiveStreamText
         pop_var(name);
     }
 
+    void push_elm(const char *name, size_t i)
+    {
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+    }
+
 private:
 
     void _indentw()
@@ -353,6 +730,8 @@ private:
 struct ArchiveStreamBinary
 {
 
+    enum : bool { is_binary = true };
+
     bool writing = true;
     FILE* file = nullptr;
 #ifdef C4_DEBUG
@@ -374,6 +753,12 @@ struct ArchiveStreamBinary
         }
     }
 
+    void flush()
+    {
+        if(writing && file)
+            fflush(file);
+    }
+
     void push_var(const char *name)
     {
     }
@@ -420,6 +805,3281 @@ struct ArchiveStreamBinary
     {
     }
 
+    /** go past numb bytes, when reading */
+    void skip(size_t numb)
+    {
+        C4_CHECK( ! writing);
+        C4_CHECK(fseek(file, static_cast< long >(numb), SEEK_CUR) == 0);
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+/** A memory buffer for writing to a FILE in blocks: the data is appended
+ * to the buffer, which grows as needed, and the buffer is written to the
+ * file once it reaches block_size bytes, or on flush(). Data bigger than
+ * a block goes directly to the file. */
+struct FileWriteBuffer
+{
+
+    FILE* file = nullptr;
+    size_t block_size = 0;
+    std::unique_ptr< char[] > buf;
+    size_t cap = 0;  //< the size of buf
+    size_t pos = 0;  //< the size of the data in buf
+    bool pending = false;  //< whether buf was bypassed since the last flush()
+
+    void reset(FILE *which, size_t block)
+    {
+        C4_CHECK(block > 0);
+        file = which;
+        block_size = block;
+        pos = 0;
+        pending = false;
+    }
+
+    void append(void const* data, size_t numb)
+    {
+        if(pos + numb <= cap)
+        {
+            memcpy(buf.get() + pos, data, numb);
+            pos += numb;
+        }
+        else
+        {
+            _append(data, numb);
+        }
+    }
+
+    /** get a pointer to room for writing up to numb bytes in the buffer;
+     * then call commit() with the number of bytes written */
+    char* room(size_t numb)
+    {
+        return pos + numb <= cap ? buf.get() + pos : _room(numb);
+    }
+    void commit(size_t numb)
+    {
+        C4_XASSERT(pos + numb <= cap);
+        pos += numb;
+    }
+
+    void flush()
+    {
+        if( ! file || ( ! pos && ! pending))
+            return;
+        _write_buf();
+        fflush(file);
+        pending = false;
+    }
+
+private:
+
+    C4_SERIALIZE_NOINLINE void _append(void const* data, size_t numb)
+    {
+        if( ! numb)
+            return;
+        if(numb >= block_size)
+        {
+            _write_buf();
+            size_t ret = fwrite(data, 1, numb, file);
+            C4_CHECK(ret == numb);
+            pending = true;
+            return;
+        }
+        memcpy(_room(numb), data, numb);
+        pos += numb;
+    }
+
+    C4_SERIALIZE_NOINLINE char* _room(size_t numb)
+    {
+        if(pos + numb > block_size)
+            _write_buf();
+        if(pos + numb > cap)
+        {
+            size_t sz = 2 * cap;
+            sz = sz < 256 ? 256 : sz;
+            sz = sz < block_size ? sz : block_size;
+            _reserve(sz < pos + numb ? pos + numb : sz);
+        }
+        return buf.get() + pos;
+    }
+
+    void _write_buf()
+    {
+        if( ! pos)
+            return;
+        size_t ret = fwrite(buf.get(), 1, pos, file);
+        C4_CHECK(ret == pos);
+        pos = 0;
+    }
+
+    void _reserve(size_t sz)
+    {
+        std::unique_ptr< char[] > b(new char[sz]);
+        if(pos)
+            memcpy(b.get(), buf.get(), pos);
+        buf = std::move(b);
+        cap = sz;
+    }
+
+};
+
+
+/** Read-only data in memory: a mapping of a whole file (or a copy of it
+ * where mmap() is not available), or a memory block given by the caller.
+ * With a FILE (which must have been flushed), reading starts at its
+ * current position, and flush() moves the position to the end of the
+ * data read, so close the FILE only after flush() or after release(). */
+struct MemoryInput
+{
+
+    const char *data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+    FILE *file = nullptr;
+
+    MemoryInput() = default;
+    MemoryInput(MemoryInput const&) = delete;
+    MemoryInput& operator= (MemoryInput const&) = delete;
+    ~MemoryInput() { release(); }
+
+    void open(FILE *which)
+    {
+        C4_CHECK(which != nullptr);
+        release();
+        long start = ftell(which);
+        C4_CHECK(start >= 0);
+        _map(which);
+        C4_CHECK(static_cast< size_t >(start) <= size);
+        pos = m_flushed = static_cast< size_t >(start);
+        file = which;
+    }
+    void open(const char *filename)
+    {
+        release();
+        FILE *f = fopen(filename, "rb");
+        C4_CHECK_MSG(f != nullptr, "could not open %s", filename);
+        _map(f);
+        fclose(f);
+    }
+    void open(void const* mem, size_t sz)
+    {
+        release();
+        data = static_cast< const char* >(mem);
+        size = sz;
+    }
+
+    void flush()
+    {
+        if(file && pos != m_flushed)
+        {
+            fseek(file, static_cast< long >(pos), SEEK_SET);
+            m_flushed = pos;
+        }
+    }
+
+    void release()
+    {
+        flush();
+#ifdef C4_SERIALIZE_MMAP
+        if(m_map)
+            munmap(m_map, size);
+#endif
+        m_map = nullptr;
+        m_copy.reset();
+        data = nullptr;
+        size = pos = m_flushed = 0;
+        file = nullptr;
+    }
+
+private:
+
+    void *m_map = nullptr;
+    std::unique_ptr< char[] > m_copy;
+    size_t m_flushed = 0;
+
+    void _map(FILE *f)
+    {
+#ifdef C4_SERIALIZE_MMAP
+        struct stat st;
+        int fd = fileno(f);
+        C4_CHECK(fstat(fd, &st) == 0);
+        size = static_cast< size_t >(st.st_size);
+        if(size)
+        {
+            m_map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            C4_CHECK_MSG(m_map != MAP_FAILED, "could not map the file");
+            data = static_cast< const char* >(m_map);
+        }
+#else
+        long cur = ftell(f);
+        fseek(f, 0, SEEK_END);
+        size = static_cast< size_t >(ftell(f));
+        fseek(f, 0, SEEK_SET);
+        m_copy.reset(new char[size ? size : 1]);
+        size_t ret = fread(m_copy.get(), 1, size, f);
+        C4_CHECK(ret == size);
+        fseek(f, cur, SEEK_SET);
+        data = m_copy.get();
+#endif
+    }
+
+};
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A binary stream with the same format as ArchiveStreamBinary, which
+ * goes through a memory buffer instead of calling stdio for each
+ * variable. When writing, the variables are appended to the buffer (which
+ * grows as needed) and the buffer is written to the file once it reaches
+ * block_size bytes, or on flush(). When reading, the file is read in
+ * blocks of block_size bytes. Sequences bigger than a block go directly
+ * to/from the file. So, each variable costs a memcpy().
+ *
+ * The block size is given to write_mode(). The buffer is flushed when
+ * the mode is changed and when the stream is destroyed, so the file must
+ * be closed only after this, or after calling flush(). When reading,
+ * flush() moves the file position back to the end of the data read, so
+ * that the file can be used after the archive. */
+struct ArchiveStreamBinaryBuffered
+{
+
+    enum : bool { is_binary = true };
+    enum : size_t { default_block_size = 1024 * 1024 };
+
+    bool writing = true;
+    FILE* file = nullptr;
+    size_t block_size = default_block_size; //< the size of the reads/writes to the file
+    detail::FileWriteBuffer out; //< writing
+    std::unique_ptr< char[] > buf; //< reading
+    size_t cap = 0;  //< reading: the size of buf
+    size_t pos = 0;  //< reading: the read position in buf
+    size_t end = 0;  //< reading: the size of the data in buf
+
+    ArchiveStreamBinaryBuffered() = default;
+    ArchiveStreamBinaryBuffered(ArchiveStreamBinaryBuffered const&) = delete;
+    ArchiveStreamBinaryBuffered& operator= (ArchiveStreamBinaryBuffered const&) = delete;
+    ~ArchiveStreamBinaryBuffered() { flush(); }
+
+    bool write_mode() const { return writing; }
+    void write_mode(bool yes, FILE *which = nullptr, size_t block = default_block_size)
+    {
+        flush();
+        C4_CHECK(block > 0);
+        block_size = block;
+        if(yes)
+        {
+            writing = true;
+            file = which ? which : stdout;
+            out.reset(file, block);
+        }
+        else
+        {
+            writing = false;
+            file = which ? which : stdin;
+            out.reset(nullptr, block);
+        }
+    }
+
+    void flush()
+    {
+        if(writing)
+        {
+            out.flush();
+        }
+        else if(file && end > pos)
+        {
+            fseek(file, -static_cast< long >(end - pos), SEEK_CUR);
+        }
+        pos = end = 0;
+    }
+
+    void push_var(const char *name)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var)
+    {
+        // the size is known here, so the copy is a plain load and store
+        if(writing)
+        {
+            out.append(var, sizeof(T));
+        }
+        else if(pos + sizeof(T) <= end)
+        {
+            memcpy(var, buf.get() + pos, sizeof(T));
+            pos += sizeof(T);
+        }
+        else
+        {
+            _read(var, sizeof(T));
+        }
+    }
+
+    void pop_var(const char *name)
+    {
+    }
+
+    void push_seq(const char *name, size_t num)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        size_t numb = num * sizeof(T);
+        if( ! numb)
+        {
+            return;
+        }
+        else if(writing)
+        {
+            out.append(var, numb);
+        }
+        else if(pos + numb <= end)
+        {
+            memcpy(var, buf.get() + pos, numb);
+            pos += numb;
+        }
+        else
+        {
+            _read(var, numb);
+        }
+    }
+
+    void pop_seq(const char *name, size_t num)
+    {
+    }
+
+    /** go past numb bytes, when reading */
+    void skip(size_t numb)
+    {
+        C4_CHECK( ! writing);
+        if(pos + numb <= end)
+        {
+            pos += numb;
+            return;
+        }
+        numb -= end - pos;
+        pos = end = 0;
+        C4_CHECK(fseek(file, static_cast< long >(numb), SEEK_CUR) == 0);
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+    }
+
+private:
+
+    void _read(void *var, size_t numb)
+    {
+        char *out = static_cast< char* >(var);
+        size_t avail = end - pos;
+        if(avail)
+            memcpy(out, buf.get() + pos, avail);
+        out += avail;
+        numb -= avail;
+        pos = end = 0;
+        if(numb >= block_size)
+        {
+            size_t ret = fread(out, 1, numb, file);
+            C4_CHECK(ret == numb);
+            return;
+        }
+        if(cap < block_size)
+        {
+            buf.reset(new char[block_size]);
+            cap = block_size;
+        }
+        end = fread(buf.get(), 1, block_size, file);
+        C4_CHECK(end >= numb);
+        memcpy(out, buf.get(), numb);
+        pos = numb;
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A read-only binary stream (same format as ArchiveStreamBinary) which
+ * maps the whole file in memory, so opening it costs nothing and only the
+ * pages which are used are read from disk. Variables are copied from the
+ * mapping with unaligned loads, and with Archive::view() sequences of
+ * NATIVE values are used in place, without copying.
+ *
+ * The data can come from a FILE (which must have been flushed; reading
+ * starts at its current position, and flush() moves the position to the
+ * end of the data read; so, as with ArchiveStreamBinaryBuffered, close it
+ * only after flush() or after the archive is destroyed), from a file
+ * name, or from memory. Where mmap()
+ * is not available, the file is read to memory. */
+struct ArchiveStreamMapped
+{
+
+    enum : bool { is_binary = true };
+
+    detail::MemoryInput in;
+
+    bool write_mode() const { return false; }
+    void write_mode(bool yes, FILE *which)
+    {
+        C4_CHECK_MSG( ! yes, "ArchiveStreamMapped is read-only");
+        in.open(which);
+    }
+    void write_mode(bool yes, const char *filename)
+    {
+        C4_CHECK_MSG( ! yes, "ArchiveStreamMapped is read-only");
+        in.open(filename);
+    }
+    void write_mode(bool yes, void const* mem, size_t sz)
+    {
+        C4_CHECK_MSG( ! yes, "ArchiveStreamMapped is read-only");
+        in.open(mem, sz);
+    }
+
+    void flush()
+    {
+        in.flush();
+    }
+
+    void push_var(const char *name)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var)
+    {
+        C4_CHECK(in.pos + sizeof(T) <= in.size);
+        memcpy(var, in.data + in.pos, sizeof(T));
+        in.pos += sizeof(T);
+    }
+
+    void pop_var(const char *name)
+    {
+    }
+
+    void push_seq(const char *name, size_t num)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        size_t numb = num * sizeof(T);
+        C4_CHECK(in.pos + numb <= in.size);
+        if(numb)
+            memcpy(var, in.data + in.pos, numb);
+        in.pos += numb;
+    }
+
+    template< class T >
+    T const* view(size_t num, T *copy)
+    {
+        size_t numb = num * sizeof(T);
+        C4_CHECK(in.pos + numb <= in.size);
+        T const* p = reinterpret_cast< T const* >(in.data + in.pos);
+        if(reinterpret_cast< uintptr_t >(p) % alignof(T))
+        {
+            C4_CHECK_MSG(copy != nullptr, "data is not aligned, and no copy was given");
+            memcpy(copy, p, numb);
+            p = copy;
+        }
+        in.pos += numb;
+        return p;
+    }
+
+    void pop_seq(const char *name, size_t num)
+    {
+    }
+
+    /** go past numb bytes */
+    void skip(size_t numb)
+    {
+        C4_CHECK(in.pos + numb <= in.size);
+        in.pos += numb;
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A binary stream (same format as ArchiveStreamBinary) which writes to
+ * the file in a background thread, so that serializing does not wait for
+ * the disk. The variables are appended to one of two buffers of
+ * block_size bytes; when it is full, it is handed to the writer thread,
+ * which writes it with a single fwrite() while the other buffer is
+ * filled. The caller waits only when both buffers are full.
+ *
+ * finish() hands over the data buffered so far and returns at once,
+ * giving a future which is ready when all of it is in the file (and
+ * fflush()ed), with 0 or the errno of the first failed write. After a
+ * failure nothing more is written, until write_mode() is called again.
+ * flush() waits for the writes to end, and fails with an error which was
+ * not given by finish(); if nothing was handed over yet (ie, the whole
+ * archive fits in a buffer), it writes the buffer itself. The file must
+ * be closed only after the future is ready, or after flush(), or after
+ * the archive is destroyed; with nothing written since, flush() does not
+ * use the file.
+ *
+ * Reading is synchronous, as with ArchiveStreamBinaryBuffered. */
+struct ArchiveStreamBinaryAsync
+{
+
+    enum : bool { is_binary = true };
+    enum : size_t { default_block_size = 1024 * 1024 };
+
+    bool writing = true;
+    FILE* file = nullptr;
+    size_t block_size = default_block_size;
+    ArchiveStreamBinaryBuffered in; //< reading
+
+    ArchiveStreamBinaryAsync() = default;
+    ArchiveStreamBinaryAsync(ArchiveStreamBinaryAsync const&) = delete;
+    ArchiveStreamBinaryAsync& operator= (ArchiveStreamBinaryAsync const&) = delete;
+    ~ArchiveStreamBinaryAsync()
+    {
+        flush();
+        if(m_thread.joinable())
+        {
+            {
+                std::lock_guard< std::mutex > lock(m_mutex);
+                m_quit = true;
+            }
+            m_work.notify_one();
+            m_thread.join();
+        }
+    }
+
+    bool write_mode() const { return writing; }
+    void write_mode(bool yes, FILE *which = nullptr, size_t block = default_block_size)
+    {
+        flush();
+        C4_CHECK(block > 0);
+        if(yes)
+        {
+            writing = true;
+            file = which ? which : stdout;
+            if(block != m_cap)
+            {
+                m_bufs.reset(new char[2 * block]);
+                m_cap = block;
+            }
+            block_size = block;
+            m_front = m_bufs.get();
+            m_pos = 0;
+            m_dirty = false;
+            std::lock_guard< std::mutex > lock(m_mutex);
+            m_error = 0;
+            m_error_given = false;
+        }
+        else
+        {
+            writing = false;
+            file = which ? which : stdin;
+            block_size = block;
+            in.write_mode(false, file, block);
+        }
+    }
+
+    /** hand over the buffered data to the writer thread, and return
+     * without waiting for it to be written.
+     * @return a future with 0 once all the data given so far is in the
+     * file, or with the errno of the first write which failed */
+    std::future< int > finish()
+    {
+        C4_CHECK_MSG(writing, "finish() is only for writing");
+        std::promise< int > done;
+        std::future< int > f = done.get_future();
+        _submit(&done);
+        return f;
+    }
+
+    void flush()
+    {
+        if( ! writing)
+        {
+            in.flush();
+            return;
+        }
+        if( ! file)
+            return;
+        if( ! m_thread.joinable())
+        {
+            // nothing was handed over, and this has to wait anyway: so
+            // write here, sparing the start of the thread
+            if( ! m_pos)
+                return;
+            size_t ret = fwrite(m_front, 1, m_pos, file);
+            C4_CHECK_MSG(ret == m_pos, "could not write: %s", strerror(errno));
+            m_pos = 0;
+            fflush(file);
+            return;
+        }
+        bool given;
+        int err;
+        {
+            std::unique_lock< std::mutex > lock(m_mutex);
+            m_done.wait(lock, [this]{ return ! m_busy; });
+            given = m_error_given;
+            err = m_error;
+        }
+        if(m_pos || m_dirty)
+            err = finish().get();
+        C4_CHECK_MSG(err == 0 || given, "could not write: %s", strerror(err));
+    }
+
+    void push_var(const char *name)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var)
+    {
+        if( ! writing)
+            in(var);
+        else if(m_pos + sizeof(T) <= block_size)
+        {
+            memcpy(m_front + m_pos, var, sizeof(T));
+            m_pos += sizeof(T);
+        }
+        else
+            _append(var, sizeof(T));
+    }
+
+    void pop_var(const char *name)
+    {
+    }
+
+    void push_seq(const char *name, size_t num)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        size_t numb = num * sizeof(T);
+        if( ! writing)
+            in(var, num);
+        else if(m_pos + numb <= block_size)
+        {
+            if(numb)
+                memcpy(m_front + m_pos, var, numb);
+            m_pos += numb;
+        }
+        else
+            _append(var, numb);
+    }
+
+    void pop_seq(const char *name, size_t num)
+    {
+    }
+
+    /** go past numb bytes, when reading */
+    void skip(size_t numb)
+    {
+        C4_CHECK( ! writing);
+        in.skip(numb);
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+    }
+
+private:
+
+    std::unique_ptr< char[] > m_bufs; //< the two buffers, one after the other
+    size_t m_cap = 0; //< the size of each buffer
+    char *m_front = nullptr; //< the buffer being filled
+    size_t m_pos = 0; //< the size of the data in the front buffer
+    bool m_dirty = false; //< data was handed over since the last fflush()
+
+    // shared with the writer thread, under m_mutex
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_work; //< the writer has a job
+    std::condition_variable m_done; //< the writer ended its job
+    bool m_busy = false; //< the writer has a job (the back buffer is in use)
+    bool m_quit = false;
+    const char *m_job_data = nullptr;
+    size_t m_job_size = 0;
+    FILE *m_job_file = nullptr;
+    std::promise< int > m_job_done; //< valid when the job must also end with fflush()
+    bool m_job_finish = false;
+    int m_error = 0; //< the errno of the first failed write
+    bool m_error_given = false; //< whether m_error was given by finish()
+
+    /** fill the front buffer, handing it over each time it is full */
+    C4_SERIALIZE_NOINLINE void _append(void const* var, size_t numb)
+    {
+        const char *data = static_cast< const char* >(var);
+        while(numb)
+        {
+            size_t n = block_size - m_pos;
+            n = n < numb ? n : numb;
+            memcpy(m_front + m_pos, data, n);
+            m_pos += n;
+            data += n;
+            numb -= n;
+            if(m_pos == block_size)
+                _submit(nullptr);
+        }
+    }
+
+    /** wait until the writer is free, and give it the front buffer. When
+     * done is given, the writer also calls fflush() and sets its value. */
+    void _submit(std::promise< int > *done)
+    {
+        if( ! m_pos && ! done)
+            return;
+        std::unique_lock< std::mutex > lock(m_mutex);
+        m_done.wait(lock, [this]{ return ! m_busy; });
+        if( ! m_thread.joinable())
+            m_thread = std::thread(&ArchiveStreamBinaryAsync::_writer, this);
+        m_busy = true;
+        m_job_data = m_front;
+        m_job_size = m_pos;
+        m_job_file = file;
+        m_job_finish = done != nullptr;
+        m_dirty = ! m_job_finish; // a finish job ends with fflush()
+        if(done)
+            m_job_done = std::move(*done);
+        lock.unlock();
+        m_work.notify_one();
+        m_front = m_front == m_bufs.get() ? m_bufs.get() + block_size : m_bufs.get();
+        m_pos = 0;
+    }
+
+    void _writer()
+    {
+        std::unique_lock< std::mutex > lock(m_mutex);
+        while(true)
+        {
+            m_work.wait(lock, [this]{ return m_busy || m_quit; });
+            if( ! m_busy)
+                return;
+            int err = m_error;
+            const char *data = m_job_data;
+            size_t size = m_job_size;
+            FILE *f = m_job_file;
+            lock.unlock();
+            if( ! err && size && fwrite(data, 1, size, f) != size)
+                err = errno ? errno : EIO;
+            if( ! err && m_job_finish && fflush(f) != 0)
+                err = errno ? errno : EIO;
+            lock.lock();
+            m_error = err;
+            if(m_job_finish)
+            {
+                m_job_done.set_value(err);
+                m_job_done = std::promise< int >();
+                m_error_given = m_error_given || err != 0;
+            }
+            m_busy = false;
+            m_done.notify_all();
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** the byte order of the values in binary archives */
+enum class Endian_e : int
+{
+    LITTLE = 0,
+    BIG = 1,
+#ifdef C4_SERIALIZE_BIG_ENDIAN
+    NATIVE = BIG,
+#else
+    NATIVE = LITTLE,
+#endif
+};
+
+namespace detail {
+
+/** the types whose bytes are swapped in archives of another byte order:
+ * integers, floating point values and enums, of 2, 4 or 8 bytes. The
+ * bytes of other types are written as they are. */
+template< class T, class A = typename tag_arith< T >::type >
+struct is_swappable
+{
+    enum : bool { value = std::is_arithmetic< A >::value && (sizeof(A) == 2 || sizeof(A) == 4 || sizeof(A) == 8) };
+};
+
+inline uint16_t bswap(uint16_t v) { return static_cast< uint16_t >((v >> 8) | (v << 8)); }
+#if defined(__GNUC__) || defined(__clang__)
+inline uint32_t bswap(uint32_t v) { return __builtin_bswap32(v); }
+inline uint64_t bswap(uint64_t v) { return __builtin_bswap64(v); }
+#else
+inline uint32_t bswap(uint32_t v)
+{
+    return (v >> 24) | ((v >> 8) & 0xff00u) | ((v << 8) & 0xff0000u) | (v << 24);
+}
+inline uint64_t bswap(uint64_t v)
+{
+    return (uint64_t(bswap(static_cast< uint32_t >(v))) << 32) | bswap(static_cast< uint32_t >(v >> 32));
+}
+#endif
+
+template< size_t N > struct bswap_uint;
+template<> struct bswap_uint< 2 > { using type = uint16_t; };
+template<> struct bswap_uint< 4 > { using type = uint32_t; };
+template<> struct bswap_uint< 8 > { using type = uint64_t; };
+
+/** copy num values of N bytes from src to dst, swapping the bytes of
+ * each one. dst and src may be the same. With SSSE3, 16 bytes are
+ * swapped at once with a byte shuffle. */
+template< size_t N >
+void bswap_n(void *dst, void const* src, size_t num)
+{
+    using U = typename bswap_uint< N >::type;
+    char *d = static_cast< char* >(dst);
+    const char *s = static_cast< const char* >(src);
+    size_t i = 0;
+#ifdef C4_SERIALIZE_SSSE3
+    const __m128i shuf = N == 2 ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+        : N == 4 ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+        : _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    for( ; (i + 16 / N) <= num; i += 16 / N)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast< __m128i const* >(s + i * N));
+        _mm_storeu_si128(reinterpret_cast< __m128i* >(d + i * N), _mm_shuffle_epi8(v, shuf));
+    }
+#endif
+    for( ; i < num; ++i)
+    {
+        U v;
+        memcpy(&v, s + i * N, N);
+        v = bswap(v);
+        memcpy(d + i * N, &v, N);
+    }
+}
+
+/** swap in place the bytes of a field of num objects of stride bytes */
+template< size_t N >
+void bswap_strided(char *data, size_t num, size_t stride, size_t count)
+{
+    using U = typename bswap_uint< N >::type;
+    if(count != 1)
+    {
+        for(size_t j = 0; j < num; ++j, data += stride)
+            bswap_n< N >(data, data, count);
+        return;
+    }
+    for(size_t j = 0; j < num; ++j, data += stride)
+    {
+        U v;
+        memcpy(&v, data, N);
+        v = bswap(v);
+        memcpy(data, &v, N);
+    }
+}
+
+/** swap in place the bytes of the fields of num objects of the given size
+ * and schema. As the fields cover the whole object (see
+ * serialize_category), the objects are a plain sequence of scalars when
+ * all the fields have the same size, and are swapped in bulk; otherwise
+ * they are swapped one field at a time. */
+inline void bswap_fields(char *data, size_t num, size_t size, SchemaField const* fields, size_t num_fields)
+{
+    size_t same = num_fields ? tag_scalar_size(fields[0].code) : 0;
+    for(size_t i = 1; i < num_fields && same; ++i)
+        same = tag_scalar_size(fields[i].code) == same ? same : 0;
+    switch(same)
+    {
+    case 1: return;
+    case 2: bswap_n< 2 >(data, data, num * size / 2); return;
+    case 4: bswap_n< 4 >(data, data, num * size / 4); return;
+    case 8: bswap_n< 8 >(data, data, num * size / 8); return;
+    default: break;
+    }
+    for(size_t i = 0; i < num_fields; ++i)
+    {
+        SchemaField const& f = fields[i];
+        switch(tag_scalar_size(f.code))
+        {
+        case 2: bswap_strided< 2 >(data + f.offset, num, size, f.count); break;
+        case 4: bswap_strided< 4 >(data + f.offset, num, size, f.count); break;
+        case 8: bswap_strided< 8 >(data + f.offset, num, size, f.count); break;
+        default: break;
+        }
+    }
+}
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+/** A binary stream with a given byte order, so that archives can be moved
+ * between hosts of different byte order. It is an
+ * ArchiveStreamBinaryBuffered (same format, buffers, and use), which
+ * swaps the bytes of the values when the byte order is not the one of the
+ * host: scalars on the fly, and sequences in bulk, with SSSE3 shuffles
+ * where available. Sequences are swapped straight into the write buffer,
+ * and in place after reading. CUSTOM_TXT classes are still copied with
+ * memcpy(), and their fields are then swapped as given by their
+ * serialize_schema. Other types (see detail::is_swappable) are written
+ * as they are.
+ *
+ * When the byte order is the one of the host, this is exactly
+ * ArchiveStreamBinaryBuffered, with memcpy() for everything. */
+template< Endian_e E >
+struct ArchiveStreamBinaryEndian : public ArchiveStreamBinaryBuffered
+{
+
+    enum : bool { swapped = E != Endian_e::NATIVE };
+    enum : size_t { chunk_size = 4096 }; //< the number of bytes swapped at once when writing
+
+    template< class T >
+    void operator() (T *var)
+    {
+        _values(var, 1, _swap_kind< T >());
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        _values(var, num, _swap_kind< T >());
+    }
+
+private:
+
+    enum : int { NO_SWAP, SWAP_SCALAR, SWAP_SCHEMA };
+
+    template< class T >
+    struct _swap_kind : public std::integral_constant< int,
+        ( ! swapped ? NO_SWAP
+          : detail::is_swappable< T >::value ? SWAP_SCALAR
+          : (serialize_schema< T >::num_fields > 0) ? SWAP_SCHEMA
+          : NO_SWAP) >
+    {
+    };
+
+    template< class T >
+    void _values(T *var, size_t num, std::integral_constant< int, NO_SWAP >)
+    {
+        static_assert( ! swapped || serialize_category< T >::value != (int)SerializeCategory_e::CUSTOM_TXT,
+                      "the fields of a CUSTOM_TXT class can only be swapped with its serialize_schema");
+        ArchiveStreamBinaryBuffered::operator()(var, num);
+    }
+
+    template< class T, int K >
+    void _values(T *var, size_t num, std::integral_constant< int, K >)
+    {
+        if(writing)
+        {
+            const size_t chunk = sizeof(T) < chunk_size ? chunk_size / sizeof(T) : 1;
+            for(size_t i = 0; i < num; i += chunk)
+            {
+                size_t n = num - i < chunk ? num - i : chunk;
+                char *p = out.room(n * sizeof(T));
+                _swap(p, var + i, n, std::integral_constant< int, K >());
+                out.commit(n * sizeof(T));
+            }
+        }
+        else
+        {
+            ArchiveStreamBinaryBuffered::operator()(var, num);
+            _swap(var, var, num, std::integral_constant< int, K >());
+        }
+    }
+
+    template< class T >
+    static void _swap(void *dst, T const* src, size_t num, std::integral_constant< int, SWAP_SCALAR >)
+    {
+        detail::bswap_n< sizeof(T) >(dst, src, num);
+    }
+    template< class T >
+    static void _swap(void *dst, T const* src, size_t num, std::integral_constant< int, SWAP_SCHEMA >)
+    {
+        if(dst != src)
+            memcpy(dst, src, num * sizeof(T));
+        detail::bswap_fields(static_cast< char* >(dst), num, sizeof(T),
+                             serialize_schema< T >::fields(), serialize_schema< T >::num_fields);
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+/** the maximum number of characters written by txt_format() */
+enum : size_t { txt_max_chars = 32 };
+
+template< class U >
+size_t txt_format_unsigned(char *buf, U v)
+{
+    static const char pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    size_t num_digits = 1;
+    for(U t = v; t >= 10; t /= 10)
+        ++num_digits;
+    // write the digits in place from the end, two at a time
+    char *p = buf + num_digits;
+    while(v >= 100)
+    {
+        size_t i = static_cast< size_t >(v % 100) * 2;
+        v /= 100;
+        p -= 2;
+        p[0] = pairs[i];
+        p[1] = pairs[i + 1];
+    }
+    if(v >= 10)
+    {
+        p[-2] = pairs[2 * v];
+        p[-1] = pairs[2 * v + 1];
+    }
+    else
+    {
+        p[-1] = static_cast< char >('0' + v);
+    }
+    return num_digits;
+}
+
+template< class U, class T >
+size_t txt_format_integer(char *buf, T v, std::true_type /*is_signed*/)
+{
+    if(v < 0)
+    {
+        *buf = '-';
+        return 1 + txt_format_unsigned(buf + 1, U(0) - static_cast< U >(v));
+    }
+    return txt_format_unsigned(buf, static_cast< U >(v));
+}
+template< class U, class T >
+size_t txt_format_integer(char *buf, T v, std::false_type /*is_signed*/)
+{
+    return txt_format_unsigned(buf, static_cast< U >(v));
+}
+
+/** format an integer, with the same output as printf() */
+template< class T >
+typename std::enable_if< std::is_integral< T >::value, size_t >::type
+txt_format(char *buf, T v)
+{
+    // do the divisions in 32 bits for the smaller types
+    using U = typename std::conditional< (sizeof(T) <= 4), uint32_t, uint64_t >::type;
+    return txt_format_integer< U >(buf, v, std::is_signed< T >());
+}
+
+inline float  txt_strtor(const char *s, char **end, float  *) { return strtof(s, end); }
+inline double txt_strtor(const char *s, char **end, double *) { return strtod(s, end); }
+
+/** format a floating point value. This is the same as printf()'s "%g"
+ * when its 6 significant digits give back the value; otherwise, more
+ * digits are used, the fewest which give back the value. So the output
+ * is the same as ArchiveStreamText's, except that the values are not
+ * rounded. */
+template< class T >
+typename std::enable_if< std::is_floating_point< T >::value, size_t >::type
+txt_format(char *buf, T v)
+{
+    enum : int { max_digits = std::numeric_limits< T >::max_digits10 };
+    // "%g" writes whole numbers below 1e6 as integers (but keeps the
+    // sign of -0)
+    if(v > T(-1e6) && v < T(1e6) && v == static_cast< T >(static_cast< int32_t >(v))
+       && (v != 0 || ! std::signbit(v)))
+        return txt_format(buf, static_cast< int32_t >(v));
+#ifdef C4_SERIALIZE_CHARCONV
+    char *last = buf + txt_max_chars;
+    std::to_chars_result r = std::to_chars(buf, last, v, std::chars_format::general, 6);
+    T back;
+    std::from_chars(buf, r.ptr, back);
+    if(back == v || v != v)
+        return static_cast< size_t >(r.ptr - buf);
+    // count the significant digits of the shortest representation,
+    // and use those (the nearest value with more digits is at least
+    // as close, but check anyway)
+    r = std::to_chars(buf, last, v);
+    int digits = 0, zeros = 0;
+    for(char *c = buf; c < r.ptr && *c != 'e'; ++c)
+    {
+        if(*c == '0')
+            zeros += (digits > 0);
+        else if(*c >= '1' && *c <= '9')
+            digits += zeros + 1, zeros = 0;
+    }
+    int prec = digits < 6 ? 6 : digits;
+    r = std::to_chars(buf, last, v, std::chars_format::general, prec);
+    std::from_chars(buf, r.ptr, back);
+    if(back != v)
+        r = std::to_chars(buf, last, v, std::chars_format::general, (int)max_digits);
+    return static_cast< size_t >(r.ptr - buf);
+#else
+    int ret = 0;
+    for(int prec = 6; prec <= max_digits; ++prec)
+    {
+        ret = snprintf(buf, txt_max_chars, "%.*g", prec, static_cast< double >(v));
+        C4_CHECK(ret > 0 && static_cast< size_t >(ret) < txt_max_chars);
+        if(v != v || txt_strtor(buf, nullptr, &v) == v)
+            break;
+    }
+    return static_cast< size_t >(ret);
+#endif
+}
+
+/** parse an integer from [b,e[. Returns the end of the number, or null
+ * if there is no number or it does not fit in T. */
+template< class T >
+typename std::enable_if< std::is_integral< T >::value, const char* >::type
+txt_parse(const char *b, const char *e, T *v)
+{
+    using U = typename std::make_unsigned< T >::type;
+    bool neg = false;
+    if(b < e && (*b == '-' || *b == '+'))
+    {
+        neg = (*b == '-');
+        if(neg && ! std::is_signed< T >::value)
+            return nullptr;
+        ++b;
+    }
+    if(b == e || *b < '0' || *b > '9')
+        return nullptr;
+    while(b + 1 < e && *b == '0' && b[1] >= '0' && b[1] <= '9')
+        ++b;
+    // 19 digits always fit in 64 bits, so check for overflow only after
+    const char *first = b;
+    uint64_t acc = 0;
+    for( ; b < e && *b >= '0' && *b <= '9' && b - first < 19; ++b)
+        acc = 10 * acc + static_cast< uint64_t >(*b - '0');
+    if(b < e && *b >= '0' && *b <= '9')
+    {
+        uint64_t d = static_cast< uint64_t >(*b - '0');
+        if(acc > (std::numeric_limits< uint64_t >::max() - d) / 10 || (++b < e && *b >= '0' && *b <= '9'))
+            return nullptr;
+        acc = 10 * acc + d;
+    }
+    uint64_t limit = static_cast< U >(std::numeric_limits< T >::max()) + (neg ? 1 : 0);
+    if(acc > limit)
+        return nullptr;
+    *v = static_cast< T >(neg ? U(0) - static_cast< U >(acc) : static_cast< U >(acc));
+    return b;
+}
+
+/** parse a floating point value from [b,e[. Returns the end of the
+ * number, or null if there is no number. */
+template< class T >
+typename std::enable_if< std::is_floating_point< T >::value, const char* >::type
+txt_parse(const char *b, const char *e, T *v)
+{
+    if(b < e && *b == '+')
+        ++b;
+    // whole numbers (as written for whole values) of up to 15 digits are
+    // exact in a double, so the conversion to T rounds only once
+    const char *p = b + (b < e && *b == '-');
+    const char *first = p;
+    uint64_t acc = 0;
+    for( ; p < e && *p >= '0' && *p <= '9' && p - first < 16; ++p)
+        acc = 10 * acc + static_cast< uint64_t >(*p - '0');
+    if(p > first && p - first < 16 && (p == e || ! (*p == '.' || (*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'))))
+    {
+        double d = static_cast< double >(acc);
+        *v = static_cast< T >(*b == '-' ? -d : d);
+        return p;
+    }
+#ifdef C4_SERIALIZE_CHARCONV
+    std::from_chars_result r = std::from_chars(b, e, *v);
+    return r.ec == std::errc() ? r.ptr : nullptr;
+#else
+    // strtod() needs a null-terminated string: copy the characters
+    // which can be part of the number
+    char tmp[64];
+    size_t n = 0;
+    for( ; b + n < e && n + 1 < sizeof(tmp); ++n)
+    {
+        char c = b[n];
+        if( ! ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+               || c == '.' || c == '-' || c == '+'))
+            break;
+    }
+    memcpy(tmp, b, n);
+    tmp[n] = '\0';
+    char *end;
+    *v = txt_strtor(tmp, &end, v);
+    return end == tmp ? nullptr : b + (end - tmp);
+#endif
+}
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A text stream with the same format as ArchiveStreamText, which does
+ * not call stdio for each value. When writing, the text is formatted
+ * into a memory buffer (written to the file in blocks as with
+ * ArchiveStreamBinaryBuffered), with hand-written integer conversion
+ * and floating point values written with as many digits as needed to
+ * read them back exactly. When reading, the whole text is mapped in
+ * memory (as with ArchiveStreamMapped; or read from a memory block
+ * or from a file name), and parsed with a hand-written scanner. Like
+ * ArchiveStreamText, the reader skips any whitespace, so it also reads
+ * the output of ArchiveStreamText, and ArchiveStreamText can read its
+ * output.
+ *
+ * As with ArchiveStreamBinaryBuffered and ArchiveStreamMapped, close the
+ * FILE only after flush() or after the archive is destroyed. */
+struct ArchiveStreamTextBuffered
+{
+
+    enum : bool { is_binary = false };
+    enum : size_t { default_block_size = 1024 * 1024 };
+
+    bool writing = true;
+    int level = 0;
+    detail::FileWriteBuffer out; //< writing
+    detail::MemoryInput in; //< reading
+
+    ArchiveStreamTextBuffered() = default;
+    ArchiveStreamTextBuffered(ArchiveStreamTextBuffered const&) = delete;
+    ArchiveStreamTextBuffered& operator= (ArchiveStreamTextBuffered const&) = delete;
+    ~ArchiveStreamTextBuffered() { flush(); }
+
+    bool write_mode() const { return writing; }
+    void write_mode(bool yes, FILE *which = nullptr, size_t block = default_block_size)
+    {
+        flush();
+        in.release();
+        if(yes)
+        {
+            writing = true;
+            out.reset(which ? which : stdout, block);
+        }
+        else
+        {
+            C4_CHECK_MSG(which != nullptr, "reading needs a file which can be mapped");
+            writing = false;
+            out.reset(nullptr, block);
+            in.open(which);
+        }
+    }
+    void write_mode(bool yes, const char *filename)
+    {
+        C4_CHECK_MSG( ! yes, "can only read from a file name");
+        flush();
+        writing = false;
+        out.reset(nullptr, default_block_size);
+        in.open(filename);
+    }
+    void write_mode(bool yes, void const* mem, size_t sz)
+    {
+        C4_CHECK_MSG( ! yes, "can only read from memory");
+        flush();
+        writing = false;
+        out.reset(nullptr, default_block_size);
+        in.open(mem, sz);
+    }
+
+    void flush()
+    {
+        if(writing)
+            out.flush();
+        else
+            in.flush();
+    }
+
+    void push_var(const char *name)
+    {
+        size_t len = strlen(name);
+        if(writing)
+        {
+            char *p = _indent(len + 1);
+            memcpy(p, name, len);
+            p[len] = ' ';
+            out.commit(_indent_size() + len + 1);
+        }
+        else
+        {
+            _skipws();
+            const char *b = in.data + in.pos, *e = in.data + in.size, *p = b;
+            while(p < e && ! _isws(*p))
+                ++p;
+            C4_CHECK_MSG(static_cast< size_t >(p - b) == len && memcmp(b, name, len) == 0,
+                         "expected %s got %.*s", name, (int)(p - b), b);
+            in.pos += len;
+            _skipws();
+        }
+        ++level;
+    }
+
+    template< class T >
+    void operator() (T *var)
+    {
+        if(writing)
+        {
+            char *p = out.room(detail::txt_max_chars);
+            out.commit(detail::txt_format(p, *var));
+        }
+        else
+        {
+            _parse(var);
+        }
+    }
+
+    void pop_var(const char *name)
+    {
+        if(writing)
+        {
+            *out.room(1) = '\n';
+            out.commit(1);
+        }
+        else
+        {
+            _skipws();
+        }
+        --level;
+    }
+
+    void push_seq(const char *name, size_t num)
+    {
+        push_var(name);
+        if(writing)
+        {
+            char *p = out.room(detail::txt_max_chars + 4);
+            size_t n = 0;
+            p[n++] = '{';
+            n += detail::txt_format(p + n, num);
+            p[n++] = ' ';
+            p[n++] = '[';
+            p[n++] = '\n';
+            out.commit(n);
+        }
+        else
+        {
+            size_t check;
+            _expect('{');
+            _parse(&check);
+            C4_CHECK(check == num);
+            _skipws();
+            _expect('[');
+            _skipws();
+        }
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        if(writing)
+        {
+            for(size_t i = 0; i < num; ++i)
+            {
+                char *p = _indent(detail::txt_max_chars + 1);
+                size_t n = detail::txt_format(p, var[i]);
+                p[n++] = '\n';
+                out.commit(_indent_size() + n);
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < num; ++i)
+                _parse(var + i);
+        }
+    }
+
+    void pop_seq(const char *name, size_t num)
+    {
+        if(writing)
+        {
+            char *p = out.room(2);
+            p[0] = ']';
+            p[1] = '}';
+            out.commit(2);
+        }
+        else
+        {
+            _skipws();
+            _expect(']');
+            _expect('}');
+        }
+        pop_var(name);
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+    }
+
+private:
+
+    size_t _indent_size() const { return 2 * static_cast< size_t >(level); }
+
+    /** write the indentation, with room for numb more bytes after it.
+     * Returns where those start; the indentation is not committed. */
+    char* _indent(size_t numb)
+    {
+        size_t n = _indent_size();
+        char *p = out.room(n + numb);
+        memset(p, ' ', n);
+        return p + n;
+    }
+
+    static bool _isws(char c)
+    {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+    void _skipws()
+    {
+        while(in.pos < in.size && _isws(in.data[in.pos]))
+            ++in.pos;
+    }
+    void _expect(char c)
+    {
+        C4_CHECK_MSG(in.pos < in.size && in.data[in.pos] == c, "expected '%c'", c);
+        ++in.pos;
+    }
+
+    template< class T >
+    void _parse(T *var)
+    {
+        _skipws();
+        const char *p = detail::txt_parse(in.data + in.pos, in.data + in.size, var);
+        C4_CHECK_MSG(p != nullptr, "could not read a value at offset %zu", in.pos);
+        in.pos = static_cast< size_t >(p - in.data);
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+/** the unsigned type in which values of T are encoded as varints, or void
+ * for the types which are written with their bytes: all but the integers
+ * (and enums) bigger than one byte */
+template< class T, class A = typename tag_arith< T >::type,
+          bool = std::is_integral< A >::value && (sizeof(A) > 1) >
+struct varint_type { using type = void; };
+template< class T, class A >
+struct varint_type< T, A, true > { using type = typename std::make_unsigned< A >::type; };
+
+/** the maximum size of a varint of the unsigned type U */
+template< class U >
+constexpr size_t varint_max() { return (8 * sizeof(U) + 6) / 7; }
+
+/** map signed values to unsigned so that small magnitudes give small
+ * values: 0, -1, 1, -2, 2... -> 0, 1, 2, 3, 4... */
+template< class U, class T >
+inline U varint_zigzag(T v, std::true_type /*is_signed*/)
+{
+    U u = static_cast< U >(v);
+    return static_cast< U >(u << 1) ^ static_cast< U >(U(0) - (u >> (8 * sizeof(U) - 1)));
+}
+template< class U, class T >
+inline U varint_zigzag(T v, std::false_type /*is_signed*/)
+{
+    return static_cast< U >(v);
+}
+template< class T, class U >
+inline T varint_unzigzag(U u, std::true_type /*is_signed*/)
+{
+    return static_cast< T >(static_cast< U >(u >> 1) ^ static_cast< U >(U(0) - (u & 1)));
+}
+template< class T, class U >
+inline T varint_unzigzag(U u, std::false_type /*is_signed*/)
+{
+    return static_cast< T >(u);
+}
+
+template< class T, class U = typename varint_type< T >::type >
+inline U varint_from(T v)
+{
+    using A = typename tag_arith< T >::type;
+    return varint_zigzag< U >(static_cast< A >(v), std::is_signed< A >());
+}
+template< class T, class U >
+inline T varint_to(U u)
+{
+    using A = typename tag_arith< T >::type;
+    return static_cast< T >(varint_unzigzag< A >(u, std::is_signed< A >()));
+}
+
+/** write v with LEB128: 7 bits per byte, with the high bit set in all
+ * but the last byte. There must be room for varint_max< U >() bytes.
+ * Returns the number of bytes written. */
+template< class U >
+inline size_t varint_encode(char *p, U v)
+{
+    size_t n = 0;
+    while(v >= 0x80)
+    {
+        p[n++] = static_cast< char >((v & 0x7f) | 0x80);
+        v = static_cast< U >(v >> 7);
+    }
+    p[n++] = static_cast< char >(v);
+    return n;
+}
+
+/** the number of bytes up to the lowest nonzero byte of m, included */
+inline size_t varint_len(uint64_t m)
+{
+    C4_ASSERT(m != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast< size_t >(__builtin_ctzll(m)) / 8 + 1;
+#else
+    size_t n = 1;
+    for( ; ! (m & 0xff); m >>= 8)
+        ++n;
+    return n;
+#endif
+}
+
+/** read a LEB128 value from [p,e[. Returns the end of the value, or null
+ * if it is not complete or does not fit in U. On little endian hosts,
+ * values of up to 8 bytes are read with a single load when there are 8
+ * bytes left: the end of the value is the first byte without the high
+ * bit, and the groups of 7 bits are then joined in 3 steps, with no loop
+ * over the bytes. */
+template< class U >
+inline const char* varint_decode(const char *p, const char *e, U *v)
+{
+#ifndef C4_SERIALIZE_BIG_ENDIAN
+    uint64_t w, m;
+    if(e - p >= 8 && (memcpy(&w, p, 8), (m = ~w & 0x8080808080808080ull)))
+    {
+        size_t len = varint_len(m);
+        uint64_t x = w & (m ^ (m - 1)); // drop the bytes after the value
+        x = ((x & 0x7f007f007f007f00ull) >> 1) | (x & 0x007f007f007f007full);
+        x = ((x & 0x3fff00003fff0000ull) >> 2) | (x & 0x00003fff00003fffull);
+        x = ((x & 0x0fffffff00000000ull) >> 4) | (x & 0x000000000fffffffull);
+        if(len > varint_max< U >() || static_cast< U >(x) != x)
+            return nullptr;
+        *v = static_cast< U >(x);
+        return p + len;
+    }
+#endif
+    U r = 0;
+    for(unsigned shift = 0; p < e && shift < 8 * sizeof(U); shift += 7)
+    {
+        uint64_t b = static_cast< uint8_t >(*p++);
+        r |= static_cast< U >((b & 0x7f) << shift);
+        if( ! (b & 0x80))
+        {
+            if(shift + 7 > 8 * sizeof(U) && ((b & 0x7f) >> (8 * sizeof(U) - shift)))
+                return nullptr;
+            *v = r;
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+/** encode num values, 8 at a time: the values of a block are converted and
+ * or'ed together, and when they all fit in 7 bits (as small counters and
+ * ids do), the block is stored with a narrowing copy, which the compiler
+ * vectorizes. There must be room for num * varint_max() bytes. */
+template< class T, class U = typename varint_type< T >::type >
+size_t varint_encode_n(char *out, T const* var, size_t num)
+{
+    char *p = out;
+    size_t i = 0;
+    for( ; i + 8 <= num; i += 8)
+    {
+        U u[8];
+        U any = 0;
+        for(size_t j = 0; j < 8; ++j)
+        {
+            u[j] = varint_from(var[i + j]);
+            any |= u[j];
+        }
+        if(any < 0x80)
+        {
+            for(size_t j = 0; j < 8; ++j)
+                p[j] = static_cast< char >(u[j]);
+            p += 8;
+        }
+        else
+        {
+            for(size_t j = 0; j < 8; ++j)
+                p += varint_encode(p, u[j]);
+        }
+    }
+    for( ; i < num; ++i)
+        p += varint_encode(p, varint_from(var[i]));
+    return static_cast< size_t >(p - out);
+}
+
+/** decode num values from [p,e[, 8 at a time: when none of the next 8
+ * bytes has the high bit set, they are 8 values of one byte, which are
+ * widened with a loop that the compiler vectorizes. Returns the end of
+ * the values, or null if they are not valid. */
+template< class T, class U = typename varint_type< T >::type >
+const char* varint_decode_n(const char *p, const char *e, T *var, size_t num)
+{
+    size_t i = 0;
+    for( ; i + 8 <= num; i += 8)
+    {
+        uint64_t w;
+        if(e - p >= 8 && (memcpy(&w, p, 8), ! (w & 0x8080808080808080ull)))
+        {
+            for(size_t j = 0; j < 8; ++j)
+                var[i + j] = varint_to< T >(static_cast< U >(static_cast< uint8_t >(p[j])));
+            p += 8;
+            continue;
+        }
+        for(size_t j = 0; j < 8; ++j)
+        {
+            U u;
+            p = varint_decode(p, e, &u);
+            if( ! p)
+                return nullptr;
+            var[i + j] = varint_to< T >(u);
+        }
+    }
+    for( ; i < num; ++i)
+    {
+        U u;
+        p = varint_decode(p, e, &u);
+        if( ! p)
+            return nullptr;
+        var[i] = varint_to< T >(u);
+    }
+    return p;
+}
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A binary stream for archives with many integers of small magnitude
+ * (counters, ids, sizes): integers (and enums) wider than one byte are
+ * written with LEB128 (7 bits per byte), after a zigzag mapping for
+ * signed types, so that values up to 127 in magnitude take a single
+ * byte. Other types are written with their bytes, as with
+ * ArchiveStreamBinary. This includes the sizes of sequences, which are
+ * size_t variables. Sequences are encoded and decoded in blocks of 8,
+ * with vectorized loops for the blocks where all the values take one
+ * byte.
+ *
+ * As the size of the integers depends on their values, the members of
+ * CUSTOM_TXT classes are written one by one, as in text archives.
+ *
+ * The writer goes through a buffer as ArchiveStreamBinaryBuffered does,
+ * and the reader maps the data in memory as ArchiveStreamMapped does;
+ * so, as with those, close the FILE only after flush() or after the
+ * archive is destroyed. */
+struct ArchiveStreamVarint
+{
+
+    enum : bool { is_binary = false };
+    enum : size_t { default_block_size = 1024 * 1024 };
+    enum : size_t { chunk_size = 256 }; //< the number of values of a sequence encoded at once
+
+    bool writing = true;
+    detail::FileWriteBuffer out; //< writing
+    detail::MemoryInput in; //< reading
+
+    ArchiveStreamVarint() = default;
+    ArchiveStreamVarint(ArchiveStreamVarint const&) = delete;
+    ArchiveStreamVarint& operator= (ArchiveStreamVarint const&) = delete;
+    ~ArchiveStreamVarint() { flush(); }
+
+    bool write_mode() const { return writing; }
+    void write_mode(bool yes, FILE *which = nullptr, size_t block = default_block_size)
+    {
+        flush();
+        in.release();
+        if(yes)
+        {
+            writing = true;
+            out.reset(which ? which : stdout, block);
+        }
+        else
+        {
+            C4_CHECK_MSG(which != nullptr, "reading needs a file which can be mapped");
+            writing = false;
+            out.reset(nullptr, block);
+            in.open(which);
+        }
+    }
+    void write_mode(bool yes, const char *filename)
+    {
+        C4_CHECK_MSG( ! yes, "can only read from a file name");
+        flush();
+        writing = false;
+        out.reset(nullptr, default_block_size);
+        in.open(filename);
+    }
+    void write_mode(bool yes, void const* mem, size_t sz)
+    {
+        C4_CHECK_MSG( ! yes, "can only read from memory");
+        flush();
+        writing = false;
+        out.reset(nullptr, default_block_size);
+        in.open(mem, sz);
+    }
+
+    void flush()
+    {
+        if(writing)
+            out.flush();
+        else
+            in.flush();
+    }
+
+    void push_var(const char *name)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var)
+    {
+        _value(var, static_cast< typename detail::varint_type< T >::type* >(nullptr));
+    }
+
+    void pop_var(const char *name)
+    {
+    }
+
+    void push_seq(const char *name, size_t num)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        _values(var, num, static_cast< typename detail::varint_type< T >::type* >(nullptr));
+    }
+
+    void pop_seq(const char *name, size_t num)
+    {
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+    }
+
+private:
+
+    template< class T, class U >
+    void _value(T *var, U*)
+    {
+        if(writing)
+        {
+            char *p = out.room(detail::varint_max< U >());
+            out.commit(detail::varint_encode(p, detail::varint_from(*var)));
+        }
+        else if(in.pos < in.size && static_cast< uint8_t >(in.data[in.pos]) < 0x80)
+        {
+            *var = detail::varint_to< T >(static_cast< U >(static_cast< uint8_t >(in.data[in.pos++])));
+        }
+        else
+        {
+            U u;
+            const char *p = detail::varint_decode(in.data + in.pos, in.data + in.size, &u);
+            C4_CHECK_MSG(p != nullptr, "bad varint at offset %zu", in.pos);
+            in.pos = static_cast< size_t >(p - in.data);
+            *var = detail::varint_to< T >(u);
+        }
+    }
+
+    template< class T, class U >
+    void _values(T *var, size_t num, U*)
+    {
+        if(writing)
+        {
+            for(size_t i = 0; i < num; i += chunk_size)
+            {
+                size_t n = num - i < chunk_size ? num - i : chunk_size;
+                char *p = out.room(n * detail::varint_max< U >());
+                out.commit(detail::varint_encode_n(p, var + i, n));
+            }
+        }
+        else
+        {
+            const char *p = detail::varint_decode_n(in.data + in.pos, in.data + in.size, var, num);
+            C4_CHECK_MSG(p != nullptr, "bad varint after offset %zu", in.pos);
+            in.pos = static_cast< size_t >(p - in.data);
+        }
+    }
+
+    // the types which are not varints
+
+    template< class T >
+    void _value(T *var, void*)
+    {
+        _values(var, 1, static_cast< void* >(nullptr));
+    }
+
+    template< class T >
+    void _values(T *var, size_t num, void*)
+    {
+        size_t numb = num * sizeof(T);
+        if(writing)
+        {
+            out.append(var, numb);
+        }
+        else
+        {
+            C4_CHECK(in.pos + numb <= in.size);
+            if(numb)
+                memcpy(var, in.data + in.pos, numb);
+            in.pos += numb;
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+/** the id of a field in archives with field tags: 32 bit FNV-1a of the
+ * name, followed by the murmur3 finalizer.
+ * @warning must be kept in sync with field_id() in c4/regen/main.py */
+inline uint32_t field_id(const char *name)
+{
+    uint32_t h = 2166136261u;
+    for( ; *name; ++name)
+    {
+        h ^= static_cast< uint8_t >(*name);
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/** append v with LEB128 */
+inline void put_varint(std::vector< char > &buf, uint64_t v)
+{
+    char tmp[varint_max< uint64_t >()];
+    buf.insert(buf.end(), tmp, tmp + varint_encode(tmp, v));
+}
+
+/** read a LEB128 value from [p,e[. Returns the end of the value, or null
+ * if it is not complete or is longer than 64 bits. */
+inline const char* get_varint(const char *p, const char *e, uint64_t *v)
+{
+    return varint_decode(p, e, v);
+}
+
+/** a scalar read from an archive, to be converted to another type */
+struct TagValue
+{
+    uint8_t kind;
+    int64_t i;
+    uint64_t u;
+    double d;
+};
+
+template< class T >
+typename std::enable_if< std::is_floating_point< T >::value, T >::type
+tag_cast(TagValue const& v)
+{
+    return v.kind == TAG_FLOAT ? static_cast< T >(v.d)
+        : v.kind == TAG_SINT ? static_cast< T >(v.i) : static_cast< T >(v.u);
+}
+/** floating point values are saturated to the range of T, and NaN is 0 */
+template< class T >
+typename std::enable_if< std::is_integral< T >::value, T >::type
+tag_cast(TagValue const& v)
+{
+    if(v.kind == TAG_FLOAT)
+    {
+        if(v.d != v.d)
+            return T(0);
+        if(v.d <= static_cast< double >(std::numeric_limits< T >::min()))
+            return std::numeric_limits< T >::min();
+        if(v.d >= static_cast< double >(std::numeric_limits< T >::max()))
+            return std::numeric_limits< T >::max();
+        return static_cast< T >(v.d);
+    }
+    return v.kind == TAG_SINT ? static_cast< T >(v.i) : static_cast< T >(v.u);
+}
+
+template< class T >
+void tag_store(char *dst, TagValue const& v)
+{
+    T x = tag_cast< T >(v);
+    memcpy(dst, &x, sizeof(T));
+}
+
+/** convert a scalar from the type code scode to the type code dcode.
+ * Returns false if one of them is not a scalar. */
+inline bool tag_convert(char *dst, uint8_t dcode, const char *src, uint8_t scode)
+{
+    TagValue v = {uint8_t(scode & 0xf0), 0, 0, 0.};
+    switch(scode)
+    {
+    case TAG_SINT  | 0: { int8_t   x; memcpy(&x, src, 1); v.i = x; break; }
+    case TAG_SINT  | 1: { int16_t  x; memcpy(&x, src, 2); v.i = x; break; }
+    case TAG_SINT  | 2: { int32_t  x; memcpy(&x, src, 4); v.i = x; break; }
+    case TAG_SINT  | 3: { int64_t  x; memcpy(&x, src, 8); v.i = x; break; }
+    case TAG_UINT  | 0: { uint8_t  x; memcpy(&x, src, 1); v.u = x; break; }
+    case TAG_UINT  | 1: { uint16_t x; memcpy(&x, src, 2); v.u = x; break; }
+    case TAG_UINT  | 2: { uint32_t x; memcpy(&x, src, 4); v.u = x; break; }
+    case TAG_UINT  | 3: { uint64_t x; memcpy(&x, src, 8); v.u = x; break; }
+    case TAG_FLOAT | 2: { float    x; memcpy(&x, src, 4); v.d = x; break; }
+    case TAG_FLOAT | 3: { double   x; memcpy(&x, src, 8); v.d = x; break; }
+    default: return false;
+    }
+    switch(dcode)
+    {
+    case TAG_SINT  | 0: tag_store< int8_t   >(dst, v); return true;
+    case TAG_SINT  | 1: tag_store< int16_t  >(dst, v); return true;
+    case TAG_SINT  | 2: tag_store< int32_t  >(dst, v); return true;
+    case TAG_SINT  | 3: tag_store< int64_t  >(dst, v); return true;
+    case TAG_UINT  | 0: tag_store< uint8_t  >(dst, v); return true;
+    case TAG_UINT  | 1: tag_store< uint16_t >(dst, v); return true;
+    case TAG_UINT  | 2: tag_store< uint32_t >(dst, v); return true;
+    case TAG_UINT  | 3: tag_store< uint64_t >(dst, v); return true;
+    case TAG_FLOAT | 2: tag_store< float    >(dst, v); return true;
+    case TAG_FLOAT | 3: tag_store< double   >(dst, v); return true;
+    default: return false;
+    }
+}
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A binary stream where each field is tagged with the id of its name
+ * (see detail::field_id()), so that archives survive changes in the
+ * classes: readers look up the fields by id, skip the fields they do not
+ * know without decoding them, and leave unchanged the variables whose
+ * field is not in the archive. Integers and floating point values of
+ * another type than the one written are converted. Sequences read at
+ * most the number of elements written.
+ *
+ * CUSTOM_TXT classes (see serialize_schema) are written with memcpy(),
+ * together with the index of their schema: the ids, offsets and types of
+ * their fields. The schemas are written once in the header of the
+ * archive. When the schema in the archive is the same as the one of the
+ * class being read, the class is read with memcpy(), and otherwise field
+ * by field.
+ *
+ * Format (integers in host byte order; varints are LEB128):
+ *
+ *     archive := "C4TA" u8(version) varint(num_schemas) schema*
+ *                varint(body_size) field*
+ *     schema  := varint(size) varint(num_fields)
+ *                (u32(id) u8(code) varint(offset) varint(count))*
+ *     field   := u32(id) u8(code) value
+ *     value   := bytes                         for scalar codes (by size)
+ *              | u32(size) field*              for TAG_OBJECT
+ *              | u32(size) bytes               for TAG_RAW
+ *              | u32(size) varint(schema) bytes            for TAG_SCHEMA
+ *              | u32(size) varint(num) elements            for TAG_SEQ|code
+ *
+ * where the elements of sequences are the bytes of the num values, after
+ * varint(element size) for TAG_RAW and varint(schema) for TAG_SCHEMA; and
+ * for TAG_OBJECT, num times u32(size) field*.
+ *
+ * When writing, the archive is built in memory and written to the file
+ * on flush() (or when the mode is changed or the stream is destroyed).
+ * Each flush() writes a complete archive. When reading, the archive is
+ * mapped in memory as with ArchiveStreamMapped; flush() moves the FILE
+ * position to the end of the archive. */
+struct ArchiveStreamTagged
+{
+
+    enum : bool { is_binary = true };
+    enum : uint8_t { version = 1 };
+
+    bool writing = true;
+    FILE *file = nullptr;
+    detail::MemoryInput in; //< reading
+
+    ArchiveStreamTagged() = default;
+    ArchiveStreamTagged(ArchiveStreamTagged const&) = delete;
+    ArchiveStreamTagged& operator= (ArchiveStreamTagged const&) = delete;
+    ~ArchiveStreamTagged() { flush(); }
+
+    bool write_mode() const { return writing; }
+    void write_mode(bool yes, FILE *which = nullptr)
+    {
+        flush();
+        _reset();
+        if(yes)
+        {
+            writing = true;
+            file = which ? which : stdout;
+        }
+        else
+        {
+            C4_CHECK_MSG(which != nullptr, "reading needs a file which can be mapped");
+            writing = false;
+            in.open(which);
+            _rheader();
+        }
+    }
+    void write_mode(bool yes, const char *filename)
+    {
+        C4_CHECK_MSG( ! yes, "can only read from a file name");
+        flush();
+        _reset();
+        writing = false;
+        in.open(filename);
+        _rheader();
+    }
+    void write_mode(bool yes, void const* mem, size_t sz)
+    {
+        C4_CHECK_MSG( ! yes, "can only read from memory");
+        flush();
+        _reset();
+        writing = false;
+        in.open(mem, sz);
+        _rheader();
+    }
+
+    void flush()
+    {
+        if( ! writing)
+        {
+            in.flush();
+            return;
+        }
+        if( ! file || (m_body.empty() && m_wschemas.empty()))
+            return;
+        C4_CHECK_MSG(m_wstack.empty(), "flush() in the middle of a variable");
+        std::vector< char > hdr;
+        hdr.insert(hdr.end(), "C4TA", "C4TA" + 4);
+        hdr.push_back(static_cast< char >(version));
+        detail::put_varint(hdr, m_wschemas.size());
+        for(auto const& s : m_wschemas)
+        {
+            detail::put_varint(hdr, s.size);
+            detail::put_varint(hdr, s.num_fields);
+            for(size_t i = 0; i < s.num_fields; ++i)
+            {
+                SchemaField const& f = s.fields[i];
+                _put(hdr, f.id);
+                hdr.push_back(static_cast< char >(f.code));
+                detail::put_varint(hdr, f.offset);
+                detail::put_varint(hdr, f.count);
+            }
+        }
+        detail::put_varint(hdr, m_body.size());
+        size_t ret = fwrite(hdr.data(), 1, hdr.size(), file);
+        C4_CHECK(ret == hdr.size());
+        if( ! m_body.empty())
+        {
+            ret = fwrite(m_body.data(), 1, m_body.size(), file);
+            C4_CHECK(ret == m_body.size());
+        }
+        fflush(file);
+        m_body.clear();
+        m_wschemas.clear();
+    }
+
+    void push_var(const char *name)
+    {
+        if(writing)
+            _wpush(name, W_PENDING, 0);
+        else
+            _rpush(name);
+    }
+
+    template< class T >
+    void operator() (T *var)
+    {
+        if(writing)
+            _wvalue(var, 1, false);
+        else
+            _rvalue(var, 1, false);
+    }
+
+    void pop_var(const char *name)
+    {
+        if(writing)
+            _wpop();
+        else
+            m_rstack.pop_back();
+    }
+
+    void push_seq(const char *name, size_t num)
+    {
+        if(writing)
+        {
+            _wpush(name, W_PENDING_SEQ, num);
+        }
+        else
+        {
+            _rpush(name);
+            RFrame &f = m_rstack.back();
+            uint64_t n = 0;
+            if(f.present && (f.code & TAG_SEQ))
+            {
+                f.cur = detail::get_varint(f.b, f.e, &n);
+                C4_CHECK_MSG(f.cur != nullptr, "bad archive");
+            }
+            f.num = static_cast< size_t >(n);
+        }
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        if(writing)
+            _wvalue(var, num, true);
+        else
+            _rvalue(var, num, true);
+    }
+
+    void pop_seq(const char *name, size_t num)
+    {
+        pop_var(name);
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+        if(writing)
+        {
+            C4_CHECK( ! m_wstack.empty());
+            WFrame &seq = m_wstack.back();
+            C4_CHECK_MSG(seq.state == W_PENDING_SEQ || seq.state == W_OPEN_SEQ, "elements must be in a sequence");
+            if(seq.state == W_PENDING_SEQ)
+            {
+                _whead(seq.id, TAG_SEQ | TAG_OBJECT);
+                seq.len_pos = _wsize();
+                detail::put_varint(m_body, seq.num);
+                seq.state = W_OPEN_SEQ;
+            }
+            m_wstack.push_back(WFrame{0, W_OBJECT, _wsize(), 0});
+        }
+        else
+        {
+            RFrame &seq = m_rstack.back();
+            if( ! seq.present || seq.code != (TAG_SEQ | TAG_OBJECT) || i >= seq.num)
+            {
+                m_rstack.push_back(RFrame{});
+                return;
+            }
+            uint32_t len;
+            C4_CHECK_MSG(seq.cur + 4 <= seq.e, "bad archive");
+            memcpy(&len, seq.cur, 4);
+            const char *b = seq.cur + 4;
+            C4_CHECK_MSG(len <= static_cast< size_t >(seq.e - b), "bad archive");
+            seq.cur = b + len;
+            m_rstack.push_back(RFrame{b, b + len, b, TAG_OBJECT, 0, true});
+        }
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+        pop_var(name);
+    }
+
+private:
+
+    // writing
+
+    enum : uint8_t {
+        W_PENDING,     //< a variable whose value was not written yet
+        W_PENDING_SEQ, //< a sequence whose values were not written yet
+        W_OBJECT,      //< an object (or sequence element) with fields
+        W_OPEN_SEQ,    //< a sequence of objects
+        W_DONE,        //< a variable whose value was written
+    };
+    struct WFrame
+    {
+        uint32_t id;
+        uint8_t state;
+        size_t len_pos; //< where the size of the record is
+        size_t num;     //< for sequences: the number of elements
+    };
+    struct WSchema
+    {
+        SchemaField const* fields;
+        size_t num_fields;
+        size_t size;
+    };
+
+    std::vector< char > m_body;
+    std::vector< WFrame > m_wstack;
+    std::vector< WSchema > m_wschemas;
+
+    template< class I >
+    static void _put(std::vector< char > &buf, I v)
+    {
+        buf.insert(buf.end(), reinterpret_cast< const char* >(&v), reinterpret_cast< const char* >(&v) + sizeof(I));
+    }
+
+    size_t _wsize()
+    {
+        size_t pos = m_body.size();
+        m_body.resize(pos + 4);
+        return pos;
+    }
+    void _wpatch(size_t len_pos)
+    {
+        size_t len = m_body.size() - len_pos - 4;
+        C4_CHECK(len <= UINT32_MAX);
+        uint32_t l = static_cast< uint32_t >(len);
+        memcpy(&m_body[len_pos], &l, 4);
+    }
+    void _whead(uint32_t id, uint8_t code)
+    {
+        _put(m_body, id);
+        m_body.push_back(static_cast< char >(code));
+    }
+
+    /** fields in a variable make it an object */
+    void _wpush(const char *name, uint8_t state, size_t num)
+    {
+        if( ! m_wstack.empty())
+        {
+            WFrame &parent = m_wstack.back();
+            C4_CHECK_MSG(parent.state == W_PENDING || parent.state == W_OBJECT,
+                         "%s: fields must be in a variable or in a sequence element", name);
+            if(parent.state == W_PENDING)
+            {
+                _whead(parent.id, TAG_OBJECT);
+                parent.len_pos = _wsize();
+                parent.state = W_OBJECT;
+            }
+        }
+        m_wstack.push_back(WFrame{detail::field_id(name), state, 0, num});
+    }
+
+    void _wpop()
+    {
+        C4_CHECK( ! m_wstack.empty());
+        WFrame &f = m_wstack.back();
+        switch(f.state)
+        {
+        case W_PENDING: // no value: an empty object
+            _whead(f.id, TAG_OBJECT);
+            _wpatch(_wsize());
+            break;
+        case W_PENDING_SEQ: // no elements
+            _whead(f.id, TAG_SEQ | TAG_OBJECT);
+            f.len_pos = _wsize();
+            detail::put_varint(m_body, f.num);
+            _wpatch(f.len_pos);
+            break;
+        case W_OBJECT:
+        case W_OPEN_SEQ:
+            _wpatch(f.len_pos);
+            break;
+        default:
+            break;
+        }
+        m_wstack.pop_back();
+    }
+
+    template< class T >
+    size_t _wschema()
+    {
+        SchemaField const* fields = serialize_schema< T >::fields();
+        for(size_t i = 0; i < m_wschemas.size(); ++i)
+            if(m_wschemas[i].fields == fields)
+                return i;
+        m_wschemas.push_back(WSchema{fields, serialize_schema< T >::num_fields, sizeof(T)});
+        return m_wschemas.size() - 1;
+    }
+
+    template< class T >
+    void _wvalue(T const* var, size_t num, bool seq)
+    {
+        C4_CHECK( ! m_wstack.empty());
+        WFrame &f = m_wstack.back();
+        C4_CHECK(f.state == (seq ? W_PENDING_SEQ : W_PENDING));
+        uint8_t code = serialize_schema< T >::num_fields > 0 ? uint8_t(TAG_SCHEMA) : tag_code< T >();
+        _whead(f.id, static_cast< uint8_t >(seq ? TAG_SEQ | code : code));
+        if( ! seq && detail::tag_is_scalar(code))
+        {
+            _put(m_body, *var);
+        }
+        else
+        {
+            size_t len_pos = _wsize();
+            if(seq)
+                detail::put_varint(m_body, num);
+            if(code == TAG_SCHEMA)
+                detail::put_varint(m_body, _wschema< T >());
+            else if(seq && code == TAG_RAW)
+                detail::put_varint(m_body, sizeof(T));
+            const char *b = reinterpret_cast< const char* >(var);
+            m_body.insert(m_body.end(), b, b + num * sizeof(T));
+            _wpatch(len_pos);
+        }
+        f.state = W_DONE;
+    }
+
+    // reading
+
+    struct RFrame
+    {
+        const char *b, *e; //< the value of the field
+        const char *cur;   //< objects: where to look for the next field; sequences: the next element
+        uint8_t code;
+        size_t num;        //< sequences: the number of elements
+        bool present;      //< false for fields not in the archive, whose operations do nothing
+    };
+    struct RSchema
+    {
+        size_t size;
+        std::vector< SchemaField > fields;
+        SchemaField const* checked; //< the last schema compared with this one
+        bool same;                  //< whether it was the same
+    };
+
+    std::vector< RFrame > m_rstack;
+    std::vector< RSchema > m_rschemas;
+
+    void _reset()
+    {
+        m_body.clear();
+        m_wstack.clear();
+        m_wschemas.clear();
+        m_rstack.clear();
+        m_rschemas.clear();
+        in.release();
+    }
+
+    void _rheader()
+    {
+        const char *p = in.data + in.pos, *e = in.data + in.size;
+        if(p == e)
+        {
+            m_rstack.push_back(RFrame{}); // an empty archive
+            return;
+        }
+        C4_CHECK_MSG(e - p > 5 && memcmp(p, "C4TA", 4) == 0, "not a tagged archive");
+        C4_CHECK_MSG(static_cast< uint8_t >(p[4]) == version, "unknown archive version %d", (int)p[4]);
+        p += 5;
+        uint64_t num_schemas, size, num_fields, offset, count, body_size;
+        p = _rvarint(p, e, &num_schemas);
+        // check the counts before allocating: a schema takes at least
+        // 2 bytes, and a field at least 7
+        C4_CHECK_MSG(_fits(num_schemas, 2, p, e), "bad archive");
+        m_rschemas.resize(static_cast< size_t >(num_schemas));
+        for(RSchema &s : m_rschemas)
+        {
+            p = _rvarint(p, e, &size);
+            p = _rvarint(p, e, &num_fields);
+            s.size = static_cast< size_t >(size);
+            s.checked = nullptr;
+            s.same = false;
+            C4_CHECK_MSG(_fits(num_fields, 7, p, e), "bad archive");
+            s.fields.resize(static_cast< size_t >(num_fields));
+            for(SchemaField &f : s.fields)
+            {
+                C4_CHECK_MSG(e - p >= 5, "bad archive");
+                memcpy(&f.id, p, 4);
+                f.code = static_cast< uint8_t >(p[4]);
+                p = _rvarint(p + 5, e, &offset);
+                p = _rvarint(p, e, &count);
+                f.offset = static_cast< uint32_t >(offset);
+                f.count = static_cast< uint32_t >(count);
+                C4_CHECK_MSG(detail::tag_is_scalar(f.code), "bad archive");
+                size_t ssz = detail::tag_scalar_size(f.code);
+                C4_CHECK_MSG(count <= size / ssz && offset <= size - count * ssz, "bad archive");
+            }
+        }
+        p = _rvarint(p, e, &body_size);
+        C4_CHECK_MSG(body_size <= static_cast< uint64_t >(e - p), "bad archive");
+        m_rstack.push_back(RFrame{p, p + body_size, p, TAG_OBJECT, 0, true});
+        in.pos = static_cast< size_t >(p + body_size - in.data);
+    }
+
+    /** whether num values of size bytes are in [p,e[; divides, so
+     * that the sizes read from the archive can not overflow */
+    static bool _fits(uint64_t num, uint64_t size, const char *p, const char *e)
+    {
+        return ! size || num <= static_cast< uint64_t >(e - p) / size;
+    }
+
+    static const char* _rvarint(const char *p, const char *e, uint64_t *v)
+    {
+        p = detail::get_varint(p, e, v);
+        C4_CHECK_MSG(p != nullptr, "bad archive");
+        return p;
+    }
+
+    /** parse the field at p. Returns its end. */
+    static const char* _rfield(const char *p, const char *e, uint32_t *id, RFrame *f)
+    {
+        C4_CHECK_MSG(e - p >= 5, "bad archive");
+        memcpy(id, p, 4);
+        f->code = static_cast< uint8_t >(p[4]);
+        p += 5;
+        size_t len;
+        if(detail::tag_is_scalar(f->code))
+        {
+            len = detail::tag_scalar_size(f->code);
+        }
+        else
+        {
+            C4_CHECK_MSG(e - p >= 4, "bad archive");
+            uint32_t l;
+            memcpy(&l, p, 4);
+            len = l;
+            p += 4;
+        }
+        C4_CHECK_MSG(len <= static_cast< size_t >(e - p), "bad archive");
+        f->b = f->cur = p;
+        f->e = p + len;
+        f->num = 0;
+        f->present = true;
+        return f->e;
+    }
+
+    /** look for the field in the current object: first after the field
+     * found last (as fields are usually read in the order they were
+     * written), then from the start of the object */
+    void _rpush(const char *name)
+    {
+        RFrame &parent = m_rstack.back();
+        RFrame f;
+        if(parent.present && parent.code == TAG_OBJECT)
+        {
+            uint32_t want = detail::field_id(name), id;
+            const char *start = parent.cur;
+            for(const char *p = start; p < parent.e; )
+            {
+                p = _rfield(p, parent.e, &id, &f);
+                if(id == want)
+                {
+                    parent.cur = p;
+                    m_rstack.push_back(f);
+                    return;
+                }
+            }
+            for(const char *p = parent.b; p < start; )
+            {
+                p = _rfield(p, start, &id, &f);
+                if(id == want)
+                {
+                    parent.cur = p;
+                    m_rstack.push_back(f);
+                    return;
+                }
+            }
+        }
+        m_rstack.push_back(RFrame{});
+    }
+
+    template< class T >
+    void _rvalue(T *var, size_t num, bool seq)
+    {
+        RFrame &f = m_rstack.back();
+        if( ! f.present || seq != ((f.code & TAG_SEQ) != 0))
+            return;
+        uint8_t code = f.code & static_cast< uint8_t >(~TAG_SEQ);
+        const char *p = seq ? f.cur : f.b;
+        size_t n = seq ? (num < f.num ? num : f.num) : 1;
+        size_t stored = seq ? f.num : 1;
+        char *out = reinterpret_cast< char* >(var);
+        if(code == TAG_SCHEMA)
+        {
+            uint64_t idx;
+            p = _rvarint(p, f.e, &idx);
+            C4_CHECK_MSG(idx < m_rschemas.size(), "bad archive");
+            RSchema &s = m_rschemas[static_cast< size_t >(idx)];
+            C4_CHECK_MSG(_fits(stored, s.size, p, f.e), "bad archive");
+            if(serialize_schema< T >::num_fields > 0)
+                _rschema(s, p, out, n, serialize_schema< T >::fields(), serialize_schema< T >::num_fields, sizeof(T));
+        }
+        else if(code == TAG_RAW)
+        {
+            uint64_t size = static_cast< uint64_t >(f.e - p);
+            if(seq)
+                p = _rvarint(p, f.e, &size);
+            C4_CHECK_MSG(_fits(stored, size, p, f.e), "bad archive");
+            if(size == sizeof(T) && n)
+                memcpy(out, p, n * sizeof(T));
+        }
+        else if(detail::tag_is_scalar(code))
+        {
+            size_t size = detail::tag_scalar_size(code);
+            C4_CHECK_MSG(_fits(stored, size, p, f.e), "bad archive");
+            if(code == tag_code< T >())
+            {
+                if(n)
+                    memcpy(out, p, n * sizeof(T));
+            }
+            else
+            {
+                for(size_t i = 0; i < n; ++i)
+                    detail::tag_convert(out + i * sizeof(T), tag_code< T >(), p + i * size, code);
+            }
+        }
+    }
+
+    /** read n objects written with the schema s to objects with the
+     * schema given by fields and size */
+    static void _rschema(RSchema &s, const char *src, char *dst, size_t n,
+                         SchemaField const* fields, size_t num_fields, size_t size)
+    {
+        if(s.checked != fields)
+        {
+            s.checked = fields;
+            s.same = s.size == size && s.fields.size() == num_fields;
+            for(size_t i = 0; s.same && i < num_fields; ++i)
+            {
+                SchemaField const& a = s.fields[i], &b = fields[i];
+                s.same = a.id == b.id && a.offset == b.offset && a.code == b.code && a.count == b.count;
+            }
+        }
+        if(s.same)
+        {
+            if(n)
+                memcpy(dst, src, n * size);
+            return;
+        }
+        for(size_t i = 0; i < num_fields; ++i)
+        {
+            SchemaField const& want = fields[i];
+            SchemaField const* have = nullptr;
+            for(SchemaField const& f : s.fields)
+            {
+                if(f.id == want.id)
+                {
+                    have = &f;
+                    break;
+                }
+            }
+            if( ! have)
+                continue;
+            size_t count = have->count < want.count ? have->count : want.count;
+            size_t ssz = detail::tag_scalar_size(have->code), dsz = detail::tag_scalar_size(want.code);
+            for(size_t j = 0; j < n; ++j)
+            {
+                const char *s_ = src + j * s.size + have->offset;
+                char *d = dst + j * size + want.offset;
+                if(have->code == want.code)
+                    memcpy(d, s_, count * ssz);
+                else
+                    for(size_t k = 0; k < count; ++k)
+                        detail::tag_convert(d + k * dsz, want.code, s_ + k * ssz, have->code);
+            }
+        }
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A binary stream (same format as ArchiveStreamBinary) followed by an
+ * index: for each variable, sequence and element, its name path (eg
+ * "a/b/c", with the index of elements as their name, eg "a/3/c"), and the
+ * offset and size of its data. So a variable can be read without reading
+ * what comes before it, with Archive::at(). As the data has the plain
+ * binary format, it can also be read with the other binary streams, which
+ * ignore the index.
+ *
+ * The index is written at the end of the archive, by flush(), which ends
+ * the archive; the entries deeper than max_depth (given to write_mode())
+ * are not indexed. Reading maps the data in memory (as does
+ * ArchiveStreamMapped), and looks for the index at its end; so the
+ * archive must be at the end of the file. The index is:
+ *
+ *   for each entry, sorted by path:
+ *     varint path size, path, varint offset, varint size
+ *   uint64_t size of the entries in bytes
+ *   uint64_t number of entries
+ *   "C4IX"
+ */
+struct ArchiveStreamIndexed
+{
+
+    enum : bool { is_binary = true };
+    enum : size_t { default_block_size = 1024 * 1024 };
+
+    /** a variable in the index */
+    struct Entry
+    {
+        const char *path;
+        size_t path_size;
+        size_t offset; //< from the start of the archive
+        size_t size;
+    };
+
+    bool writing = true;
+    FILE *file = nullptr;
+    size_t max_depth = (size_t)-1; //< writing: the depth of the deepest indexed entries
+    detail::FileWriteBuffer out; //< writing
+    detail::MemoryInput in; //< reading
+    std::vector< Entry > index; //< reading: sorted by path
+
+    ArchiveStreamIndexed() = default;
+    ArchiveStreamIndexed(ArchiveStreamIndexed const&) = delete;
+    ArchiveStreamIndexed& operator= (ArchiveStreamIndexed const&) = delete;
+    ~ArchiveStreamIndexed() { flush(); }
+
+    bool write_mode() const { return writing; }
+    void write_mode(bool yes, FILE *which = nullptr, size_t depth = (size_t)-1)
+    {
+        flush();
+        if(yes)
+        {
+            writing = true;
+            file = which ? which : stdout;
+            max_depth = depth;
+            out.reset(file, default_block_size);
+        }
+        else
+        {
+            C4_CHECK_MSG(which != nullptr, "reading needs a file which can be mapped");
+            writing = false;
+            in.open(which);
+            _rindex();
+        }
+    }
+    void write_mode(bool yes, const char *filename)
+    {
+        C4_CHECK_MSG( ! yes, "can only read from a file name");
+        flush();
+        writing = false;
+        in.open(filename);
+        _rindex();
+    }
+    void write_mode(bool yes, void const* mem, size_t sz)
+    {
+        C4_CHECK_MSG( ! yes, "can only read from memory");
+        flush();
+        writing = false;
+        in.open(mem, sz);
+        _rindex();
+    }
+
+    /** when writing, write the index, ending the archive */
+    void flush()
+    {
+        if( ! writing)
+        {
+            in.flush();
+            return;
+        }
+        if( ! file || ( ! m_size && m_wentries.empty()))
+            return;
+        C4_CHECK_MSG(m_wstack.empty(), "flush() in the middle of a variable");
+        std::vector< size_t > order(m_wentries.size());
+        for(size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [this](size_t l, size_t r){
+            WEntry const& a = m_wentries[l], &b = m_wentries[r];
+            return m_wpaths.compare(a.path_pos, a.path_size, m_wpaths, b.path_pos, b.path_size) < 0;
+        });
+        std::vector< char > idx;
+        for(size_t i : order)
+        {
+            WEntry const& e = m_wentries[i];
+            detail::put_varint(idx, e.path_size);
+            idx.insert(idx.end(), m_wpaths.data() + e.path_pos, m_wpaths.data() + e.path_pos + e.path_size);
+            detail::put_varint(idx, e.offset);
+            detail::put_varint(idx, e.size);
+        }
+        uint64_t trailer[2] = {idx.size(), m_wentries.size()};
+        out.append(idx.data(), idx.size());
+        out.append(trailer, sizeof(trailer));
+        out.append("C4IX", 4);
+        out.flush();
+        m_size = 0;
+        m_wentries.clear();
+        m_wpaths.clear();
+        m_wpath.clear();
+    }
+
+    /** find the entry of a path, or null */
+    Entry const* find(const char *path) const
+    {
+        size_t sz = strlen(path);
+        auto it = std::lower_bound(index.begin(), index.end(), sz, [path](Entry const& e, size_t sz_){
+            return _cmp(e.path, e.path_size, path, sz_) < 0;
+        });
+        if(it == index.end() || _cmp(it->path, it->path_size, path, sz) != 0)
+            return nullptr;
+        return &*it;
+    }
+
+    /** when reading, move to the data of path; the next variable read is
+     * the one at path. Returns false if path is not in the index. */
+    bool seek(const char *path)
+    {
+        C4_CHECK_MSG( ! writing, "seek() is only for reading");
+        Entry const* e = find(path);
+        if( ! e)
+            return false;
+        in.pos = m_start + e->offset;
+        return true;
+    }
+
+    void push_var(const char *name)
+    {
+        if(writing)
+            _wpush(name, strlen(name));
+    }
+
+    template< class T >
+    void operator() (T *var)
+    {
+        if(writing)
+        {
+            out.append(var, sizeof(T));
+            m_size += sizeof(T);
+        }
+        else
+        {
+            C4_CHECK(in.pos + sizeof(T) <= m_end);
+            memcpy(var, in.data + in.pos, sizeof(T));
+            in.pos += sizeof(T);
+        }
+    }
+
+    void pop_var(const char *name)
+    {
+        if(writing)
+            _wpop();
+    }
+
+    void push_seq(const char *name, size_t num)
+    {
+        if(writing)
+            _wpush(name, strlen(name));
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        size_t numb = num * sizeof(T);
+        if( ! numb)
+            return;
+        if(writing)
+        {
+            out.append(var, numb);
+            m_size += numb;
+        }
+        else
+        {
+            C4_CHECK(in.pos + numb <= m_end);
+            memcpy(var, in.data + in.pos, numb);
+            in.pos += numb;
+        }
+    }
+
+    /** go past numb bytes, when reading */
+    void skip(size_t numb)
+    {
+        C4_CHECK( ! writing && in.pos + numb <= m_end);
+        in.pos += numb;
+    }
+
+    void pop_seq(const char *name, size_t num)
+    {
+        if(writing)
+            _wpop();
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+        if(writing)
+        {
+            char buf[24];
+            int len = snprintf(buf, sizeof(buf), "%zu", i);
+            _wpush(buf, static_cast< size_t >(len));
+        }
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+        if(writing)
+            _wpop();
+    }
+
+private:
+
+    struct WEntry
+    {
+        size_t path_pos, path_size; //< in m_wpaths
+        size_t offset, size;
+    };
+    struct WFrame
+    {
+        size_t path_size; //< the size of m_wpath before the push
+        size_t offset;
+    };
+
+    size_t m_size = 0; //< writing: the size of the data written so far
+    std::string m_wpath; //< writing: the path of the current variable
+    std::string m_wpaths; //< writing: the paths of all the entries
+    std::vector< WFrame > m_wstack;
+    std::vector< WEntry > m_wentries;
+    size_t m_start = 0; //< reading: the start of the data
+    size_t m_end = 0;   //< reading: the end of the data (ie, the start of the index)
+
+    static int _cmp(const char *a, size_t asz, const char *b, size_t bsz)
+    {
+        int c = memcmp(a, b, asz < bsz ? asz : bsz);
+        return c ? c : (asz < bsz ? -1 : (asz > bsz ? 1 : 0));
+    }
+
+    void _wpush(const char *name, size_t len)
+    {
+        m_wstack.push_back(WFrame{m_wpath.size(), m_size});
+        if(m_wstack.size() > max_depth)
+            return;
+        if( ! m_wpath.empty())
+            m_wpath += '/';
+        m_wpath.append(name, len);
+    }
+
+    void _wpop()
+    {
+        C4_CHECK(m_wstack.size() > 0);
+        WFrame f = m_wstack.back();
+        if(m_wstack.size() <= max_depth)
+        {
+            m_wentries.push_back(WEntry{m_wpaths.size(), m_wpath.size(), f.offset, m_size - f.offset});
+            m_wpaths += m_wpath;
+            m_wpath.resize(f.path_size);
+        }
+        m_wstack.pop_back();
+    }
+
+    void _rindex()
+    {
+        index.clear();
+        m_start = in.pos;
+        m_end = in.size;
+        if(in.pos == in.size)
+            return; // an empty archive
+        const char *b = in.data + in.pos, *e = in.data + in.size;
+        uint64_t trailer[2];
+        C4_CHECK_MSG(size_t(e - b) >= sizeof(trailer) + 4 && memcmp(e - 4, "C4IX", 4) == 0, "not an indexed archive");
+        memcpy(trailer, e - 4 - sizeof(trailer), sizeof(trailer));
+        size_t avail = size_t(e - b) - 4 - sizeof(trailer);
+        C4_CHECK_MSG(trailer[0] <= avail, "bad archive index");
+        const char *p = e - 4 - sizeof(trailer) - trailer[0], *pe = e - 4 - sizeof(trailer);
+        m_end = static_cast< size_t >(p - in.data);
+        // each entry takes at least 3 bytes: check it before allocating
+        C4_CHECK_MSG(trailer[1] <= trailer[0] / 3, "bad archive index");
+        index.reserve(static_cast< size_t >(trailer[1]));
+        for(uint64_t i = 0; i < trailer[1]; ++i)
+        {
+            uint64_t psz, off, sz;
+            p = detail::get_varint(p, pe, &psz);
+            C4_CHECK_MSG(p != nullptr && psz <= uint64_t(pe - p), "bad archive index");
+            const char *path = p;
+            p = detail::get_varint(p + psz, pe, &off);
+            C4_CHECK_MSG(p != nullptr, "bad archive index");
+            p = detail::get_varint(p, pe, &sz);
+            C4_CHECK_MSG(p != nullptr && off <= m_end - m_start && sz <= m_end - m_start - off, "bad archive index");
+            index.push_back(Entry{path, static_cast< size_t >(psz), static_cast< size_t >(off), static_cast< size_t >(sz)});
+        }
+        C4_CHECK_MSG(p == pe, "bad archive index");
+    }
+
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+/** a hash of a block of bytes, to check that a delta is applied to the
+ * base it was made from */
+inline uint64_t delta_hash(const char *p, size_t n)
+{
+    // FNV-1a on words, in four independent lanes so that the multiplies
+    // overlap
+    const uint64_t prime = 1099511628211ull;
+    uint64_t h[4] = {14695981039346656037ull, 1, 2, 3};
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32)
+    {
+        uint64_t w[4];
+        memcpy(w, p + i, 32);
+        for(int j = 0; j < 4; ++j)
+            h[j] = (h[j] ^ w[j]) * prime;
+    }
+    for(; i < n; ++i)
+        h[0] = (h[0] ^ static_cast< uint8_t >(p[i])) * prime;
+    return ((((h[0] * prime) ^ h[1]) * prime ^ h[2]) * prime ^ h[3]) ^ n;
+}
+
+} // namespace detail
+
+/** A stream with the changes of a binary archive from a previous one, the
+ * base: when writing, each variable and sequence is compared with memcmp()
+ * to the bytes at the same position of the base, which must be in the
+ * plain binary format (eg, from ArchiveStreamBinaryBuffered), and only
+ * the ranges which differ are written. Sequences are compared in blocks
+ * of block_size bytes, so only the changed parts of a sequence are
+ * written. Reading gives the variables of the new archive, taking them
+ * from the base where they did not change.
+ *
+ * The positions are those of the plain binary format, so the delta is
+ * small when the sizes of the sequences are the same as in the base; when
+ * a sequence grows or shrinks, all that comes after it is written.
+ *
+ * flush() ends the delta. The format is:
+ *
+ *   "C4DL", version, uint64_t base size, uint64_t hash of the base
+ *   for each change: varint gap from the end of the previous change,
+ *                    varint size (> 0), the bytes
+ *   varint 0, varint 0
+ *   varint size of the new archive
+ */
+struct ArchiveStreamDelta
+{
+
+    enum : bool { is_binary = true };
+    enum : uint8_t { version = 1 };
+    enum : size_t {
+        block_size = 64, //< the granularity of the comparison of sequences
+        merge_gap = 16,  //< changes closer than this are joined
+    };
+
+    bool writing = true;
+    FILE *file = nullptr;
+    detail::FileWriteBuffer out; //< writing
+    detail::MemoryInput in; //< reading: the delta
+
+    ArchiveStreamDelta() = default;
+    ArchiveStreamDelta(ArchiveStreamDelta const&) = delete;
+    ArchiveStreamDelta& operator= (ArchiveStreamDelta const&) = delete;
+    ~ArchiveStreamDelta() { flush(); }
+
+    bool write_mode() const { return writing; }
+    /** write the changes from a base in memory, or read the changes
+     * which were written from it */
+    void write_mode(bool yes, FILE *which, void const* base, size_t base_size)
+    {
+        flush();
+        m_basein.release();
+        _mode(yes, which, static_cast< const char* >(base), base_size);
+    }
+    /** write the changes from a base file, or read the changes which were
+     * written from it */
+    void write_mode(bool yes, FILE *which, const char *base_filename)
+    {
+        flush();
+        m_basein.open(base_filename);
+        _mode(yes, which, m_basein.data, m_basein.size);
+    }
+
+    void flush()
+    {
+        if( ! writing)
+        {
+            in.flush();
+            return;
+        }
+        if( ! file || ( ! m_size && ! m_started))
+            return;
+        _wbegin();
+        _wpatch();
+        char tmp[3 * detail::varint_max< uint64_t >()];
+        size_t n = detail::varint_encode(tmp, uint64_t(0));
+        n += detail::varint_encode(tmp + n, uint64_t(0));
+        n += detail::varint_encode(tmp + n, uint64_t(m_size));
+        out.append(tmp, n);
+        out.flush();
+        m_size = m_wend = 0;
+        m_started = false;
+    }
+
+    void push_var(const char *name)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var)
+    {
+        if(writing)
+            _wvalue(reinterpret_cast< const char* >(var), sizeof(T));
+        else
+            _rvalue(reinterpret_cast< char* >(var), sizeof(T));
+    }
+
+    void pop_var(const char *name)
+    {
+    }
+
+    void push_seq(const char *name, size_t num)
+    {
+    }
+
+    template< class T >
+    void operator() (T *var, size_t num)
+    {
+        if(writing)
+        {
+            const char *p = reinterpret_cast< const char* >(var);
+            size_t numb = num * sizeof(T);
+            // skip quickly over the big parts which did not change
+            const size_t chunk = 64 * block_size;
+            for(size_t c = 0; c < numb; c += chunk)
+            {
+                size_t cn = numb - c < chunk ? numb - c : chunk;
+                if(m_size + cn <= m_base_size && memcmp(p + c, m_base + m_size, cn) == 0)
+                {
+                    m_size += cn;
+                    continue;
+                }
+                for(size_t i = c; i < c + cn; i += block_size)
+                    _wvalue(p + i, c + cn - i < block_size ? c + cn - i : block_size);
+            }
+        }
+        else
+        {
+            _rvalue(reinterpret_cast< char* >(var), num * sizeof(T));
+        }
+    }
+
+    /** go past numb bytes, when reading */
+    void skip(size_t numb)
+    {
+        C4_CHECK( ! writing && m_rpos + numb <= m_rsize);
+        m_rpos += numb;
+    }
+
+    void pop_seq(const char *name, size_t num)
+    {
+    }
+
+    void push_elm(const char *name, size_t i)
+    {
+    }
+
+    void pop_elm(const char *name, size_t i)
+    {
+    }
+
+private:
+
+    struct Change
+    {
+        size_t offset, size;
+        const char *data; //< in the delta
+    };
+
+    detail::MemoryInput m_basein; //< the base, when given as a file
+    const char *m_base = nullptr;
+    size_t m_base_size = 0;
+
+    size_t m_size = 0;  //< writing: the size of the new archive so far
+    bool m_started = false; //< writing: whether the header was written
+    std::vector< char > m_patch; //< writing: the pending change
+    size_t m_patch_offset = 0;
+    size_t m_wend = 0;  //< writing: the end of the last change written
+
+    std::vector< Change > m_changes; //< reading
+    size_t m_rsize = 0; //< reading: the size of the new archive
+    size_t m_rpos = 0;  //< reading: the position in the new archive
+    size_t m_rchange = 0; //< reading: the first change not before m_rpos
+
+    void _mode(bool yes, FILE *which, const char *base, size_t base_size)
+    {
+        C4_CHECK(base != nullptr || base_size == 0);
+        m_base = base;
+        m_base_size = base_size;
+        m_size = m_wend = 0;
+        m_started = false;
+        m_patch.clear();
+        if(yes)
+        {
+            writing = true;
+            file = which ? which : stdout;
+            out.reset(file, 1024 * 1024);
+        }
+        else
+        {
+            C4_CHECK_MSG(which != nullptr, "reading needs a file which can be mapped");
+            writing = false;
+            file = which;
+            in.open(which);
+            _rdelta();
+        }
+    }
+
+    void _wbegin()
+    {
+        if(m_started)
+            return;
+        char hdr[5 + 2 * sizeof(uint64_t)];
+        uint64_t sz = m_base_size, h = detail::delta_hash(m_base, m_base_size);
+        memcpy(hdr, "C4DL", 4);
+        hdr[4] = static_cast< char >(version);
+        memcpy(hdr + 5, &sz, sizeof(sz));
+        memcpy(hdr + 5 + sizeof(sz), &h, sizeof(h));
+        out.append(hdr, sizeof(hdr));
+        m_started = true;
+    }
+
+    /** compare numb bytes (at most block_size) with the base */
+    void _wvalue(const char *p, size_t numb)
+    {
+        size_t off = m_size;
+        m_size += numb;
+        size_t same = off >= m_base_size ? 0 : (m_base_size - off < numb ? m_base_size - off : numb);
+        const char *b = same ? m_base + off : nullptr;
+        if(same == numb && memcmp(p, b, numb) == 0)
+            return;
+        // trim the bytes which did not change
+        size_t first = 0, last = numb;
+        while(first < same && p[first] == b[first])
+            ++first;
+        if(same == numb)
+            while(last > first && p[last - 1] == b[last - 1])
+                --last;
+        _wchange(off + first, p + first, last - first);
+    }
+
+    void _wchange(size_t offset, const char *p, size_t numb)
+    {
+        size_t pend = m_patch_offset + m_patch.size();
+        if( ! m_patch.empty() && offset - pend <= merge_gap)
+        {
+            // the bytes in between did not change: take them from the base
+            m_patch.insert(m_patch.end(), m_base + pend, m_base + offset);
+        }
+        else
+        {
+            _wpatch();
+            m_patch_offset = offset;
+        }
+        m_patch.insert(m_patch.end(), p, p + numb);
+    }
+
+    void _wpatch()
+    {
+        if(m_patch.empty())
+            return;
+        _wbegin();
+        char tmp[2 * detail::varint_max< uint64_t >()];
+        size_t n = detail::varint_encode(tmp, uint64_t(m_patch_offset - m_wend));
+        n += detail::varint_encode(tmp + n, uint64_t(m_patch.size()));
+        out.append(tmp, n);
+        out.append(m_patch.data(), m_patch.size());
+        m_wend = m_patch_offset + m_patch.size();
+        m_patch.clear();
+    }
+
+    void _rdelta()
+    {
+        m_changes.clear();
+        m_rsize = m_rpos = m_rchange = 0;
+        const char *p = in.data + in.pos, *e = in.data + in.size;
+        if(p == e)
+            return; // an empty archive
+        uint64_t sz, h;
+        C4_CHECK_MSG(size_t(e - p) >= 5 + 2 * sizeof(uint64_t) && memcmp(p, "C4DL", 4) == 0, "not a delta archive");
+        C4_CHECK_MSG(static_cast< uint8_t >(p[4]) == version, "unknown archive version %d", (int)p[4]);
+        memcpy(&sz, p + 5, sizeof(sz));
+        memcpy(&h, p + 5 + sizeof(sz), sizeof(h));
+        C4_CHECK_MSG(sz == m_base_size && h == detail::delta_hash(m_base, m_base_size),
+                     "the delta was not made from this base");
+        p += 5 + 2 * sizeof(uint64_t);
+        size_t end = 0;
+        while(true)
+        {
+            uint64_t gap, size;
+            p = detail::get_varint(p, e, &gap);
+            C4_CHECK_MSG(p != nullptr, "bad delta");
+            p = detail::get_varint(p, e, &size);
+            C4_CHECK_MSG(p != nullptr && size <= uint64_t(e - p), "bad delta");
+            if( ! size)
+                break;
+            m_changes.push_back(Change{end + size_t(gap), size_t(size), p});
+            end += size_t(gap) + size_t(size);
+            p += size;
+        }
+        uint64_t rsize;
+        p = detail::get_varint(p, e, &rsize);
+        C4_CHECK_MSG(p != nullptr && end <= rsize, "bad delta");
+        m_rsize = size_t(rsize);
+        in.pos = size_t(p - in.data); // so that flush() puts the file after the delta
+    }
+
+    void _rvalue(char *dst, size_t numb)
+    {
+        C4_CHECK_MSG(m_rpos + numb <= m_rsize, "reading past the end of the archive");
+        while(numb)
+        {
+            while(m_rchange < m_changes.size() && m_changes[m_rchange].offset + m_changes[m_rchange].size <= m_rpos)
+                ++m_rchange;
+            size_t n;
+            if(m_rchange < m_changes.size() && m_changes[m_rchange].offset <= m_rpos)
+            {
+                Change const& c = m_changes[m_rchange];
+                n = c.offset + c.size - m_rpos;
+                n = n < numb ? n : numb;
+                memcpy(dst, c.data + (m_rpos - c.offset), n);
+            }
+            else
+            {
+                size_t lim = m_rchange < m_changes.size() ? m_changes[m_rchange].offset : m_rsize;
+                n = lim - m_rpos;
+                n = n < numb ? n : numb;
+                C4_CHECK_MSG(m_rpos + n <= m_base_size, "bad delta");
+                memcpy(dst, m_base + m_rpos, n);
+            }
+            dst += n;
+            m_rpos += n;
+            numb -= n;
+        }
+    }
+
 };
 
 } // end namespace c4
@@ -0,0 +1,64 @@
+"""the serialization code of the reflected classes, for serialize.hpp.
+Shared by the regen.py of the examples which use it."""
+
+import c4.regen as regen
+
+
+serialize = regen.ClassGenerator(
+    name="serialize",
+    hdr_preamble='#include "serialize.hpp"',
+    hdr="""\
+namespace c4 {
+template <{{tpl_params}}>
+struct serialize_category< {{type}} >
+{% if is_bitwise %}
+{ enum : int { value = (int)SerializeCategory_e::CUSTOM_TXT }; };
+template <>
+struct serialize_schema< {{type}} >
+{
+    enum : size_t { num_fields = {{members|length}} };
+    static SchemaField const* fields()
+    {
+        static const SchemaField f[] = {
+            {% for m in members %}
+            schema_field< {{m.type}} >({{m.id}}u, offsetof({{type}}, {{m.name}})), // {{m.name}}
+            {% endfor %}
+        };
+        return f;
+    }
+};
+template <>
+struct serialize_columns< {{type}} >
+{
+    enum : bool { value = true };
+    template< class Walk >
+    static void walk(Walk &w)
+    {
+        {% for m in members %}
+        w.template column< {{m.type}} >("{{m.name}}", offsetof({{type}}, {{m.name}}));
+        {% endfor %}
+    }
+};
+{% else %}
+{ enum : int { value = (int)SerializeCategory_e::METHOD }; };
+{% endif %}
+} // namespace c4
+{%if is_tpl %}
+template <{{tpl_params}}>
+{% endif %}
+template <class Stream>
+void {{type}}::serialize(c4::Archive< Stream > &a, const char *name)
+{
+    {% if is_bitwise %}
+    // binary archives copy the whole object with memcpy()
+    static_assert(std::is_trivially_copyable< {{type}} >::value
+                  && std::is_standard_layout< {{type}} >::value
+                  && sizeof({{type}}) == {% for m in members %}{{ " + " if not loop.first }}sizeof({{m.name}}){% endfor %},
+                  "{{type}}: the layout does not match the generated code; regenerate it");
+    {% endif %}
+    {% for m in members %}
+    c4::serialize< {{m.type}} >(a, "{{m.name}}", &this->{{m.name}});
+    {% endfor %}
+}
+""",
+)
@@ -0,0 +1,235 @@
+#ifndef _C4_SERIALIZE_STD_HPP_
+#define _C4_SERIALIZE_STD_HPP_
+
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "serialize.hpp"
+
+/** @file serialize_std.hpp serialize() for the standard containers.
+ *
+ * Containers with a variable size are written as their "size", followed
+ * by their elements. Vectors and strings are resized once before reading,
+ * and their elements go as a single sequence, so NATIVE (and, in binary
+ * archives, CUSTOM_TXT) elements are read and written in bulk. Maps are
+ * read into a container sized for all the entries: unordered maps reserve
+ * their buckets, and maps insert with a hint at the end, which is
+ * constant time as the entries are read in order. When the keys and the
+ * values are trivially copyable, they are gathered into two sequences,
+ * "keys" and "vals", which go in bulk; otherwise each entry is written as
+ * a "key" and a "val". */
+
+namespace c4 {
+
+template< class T, class A >
+struct serialize_category< std::vector< T, A > >
+{
+    enum : int { value = (int)SerializeCategory_e::CUSTOM };
+};
+template< class C, class Tr, class A >
+struct serialize_category< std::basic_string< C, Tr, A > >
+{
+    enum : int { value = (int)SerializeCategory_e::CUSTOM };
+};
+template< class T, size_t N >
+struct serialize_category< std::array< T, N > >
+{
+    enum : int { value = (int)SerializeCategory_e::CUSTOM };
+};
+template< class K, class V, class C, class A >
+struct serialize_category< std::map< K, V, C, A > >
+{
+    enum : int { value = (int)SerializeCategory_e::CUSTOM };
+};
+template< class K, class V, class H, class E, class A >
+struct serialize_category< std::unordered_map< K, V, H, E, A > >
+{
+    enum : int { value = (int)SerializeCategory_e::CUSTOM };
+};
+
+//-----------------------------------------------------------------------------
+
+template< class T, class A, class Stream >
+void serialize(Archive< Stream > &a, const char *name, std::vector< T, A > *var)
+{
+    size_t sz = var->size();
+    a("size", &sz);
+    if( ! a.write_mode())
+        var->resize(sz);
+    a("elms", var->data(), sz);
+}
+
+/** the bits of vector< bool > are not addressable, so they go as bytes */
+template< class A, class Stream >
+void serialize(Archive< Stream > &a, const char *name, std::vector< bool, A > *var)
+{
+    size_t sz = var->size();
+    a("size", &sz);
+    std::unique_ptr< uint8_t[] > bytes(new uint8_t[sz ? sz : 1]);
+    if(a.write_mode())
+    {
+        for(size_t i = 0; i < sz; ++i)
+            bytes[i] = (*var)[i];
+        a("elms", bytes.get(), sz);
+    }
+    else
+    {
+        a("elms", bytes.get(), sz);
+        var->assign(bytes.get(), bytes.get() + sz);
+    }
+}
+
+/** the characters go as the unsigned integers of their size, as text
+ * archives have no format for characters */
+template< class C, class Tr, class A, class Stream >
+void serialize(Archive< Stream > &a, const char *name, std::basic_string< C, Tr, A > *var)
+{
+    using U = typename std::make_unsigned< C >::type;
+    size_t sz = var->size();
+    a("size", &sz);
+    if( ! a.write_mode())
+        var->resize(sz);
+    a("elms", reinterpret_cast< U* >(&(*var)[0]), sz);
+}
+
+template< class T, size_t N, class Stream >
+void serialize(Archive< Stream > &a, const char *name, std::array< T, N > *var)
+{
+    a("elms", var->data(), N);
+}
+
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+template< class K, class V, class C, class A >
+void map_reserve(std::map< K, V, C, A > &, size_t)
+{
+}
+template< class K, class V, class H, class E, class A >
+void map_reserve(std::unordered_map< K, V, H, E, A > &m, size_t n)
+{
+    m.reserve(n);
+}
+
+/** bools are not scalars of the archives, so in maps they go as bytes,
+ * as in vector< bool > */
+template< class T >
+struct map_stored
+{
+    using type = T;
+};
+template<>
+struct map_stored< bool >
+{
+    using type = uint8_t;
+};
+
+template< class T, class Stream >
+void map_item(Archive< Stream > &a, const char *name, T *v)
+{
+    a(name, v);
+}
+template< class Stream >
+void map_item(Archive< Stream > &a, const char *name, bool *v)
+{
+    uint8_t b = *v;
+    a(name, &b);
+    *v = b != 0;
+}
+
+template< class M >
+struct map_is_bulk
+{
+    enum : bool {
+        value = std::is_trivially_copyable< typename M::key_type >::value
+             && std::is_trivially_copyable< typename M::mapped_type >::value
+    };
+};
+
+template< class M, class Stream >
+void serialize_map(Archive< Stream > &a, M *var, std::true_type /*bulk*/)
+{
+    using K = typename M::key_type;
+    using V = typename M::mapped_type;
+    using KS = typename map_stored< K >::type;
+    using VS = typename map_stored< V >::type;
+    size_t sz = var->size();
+    a("size", &sz);
+    std::vector< KS > keys(sz);
+    std::vector< VS > vals(sz);
+    if(a.write_mode())
+    {
+        size_t i = 0;
+        for(auto const& kv : *var)
+        {
+            keys[i] = static_cast< KS >(kv.first);
+            vals[i] = static_cast< VS >(kv.second);
+            ++i;
+        }
+        a("keys", keys.data(), sz);
+        a("vals", vals.data(), sz);
+    }
+    else
+    {
+        a("keys", keys.data(), sz);
+        a("vals", vals.data(), sz);
+        var->clear();
+        map_reserve(*var, sz);
+        for(size_t i = 0; i < sz; ++i)
+            var->emplace_hint(var->end(), static_cast< K >(keys[i]), static_cast< V >(vals[i]));
+    }
+}
+
+template< class M, class Stream >
+void serialize_map(Archive< Stream > &a, M *var, std::false_type /*bulk*/)
+{
+    using K = typename M::key_type;
+    using V = typename M::mapped_type;
+    size_t sz = var->size();
+    a("size", &sz);
+    if(a.write_mode())
+    {
+        for(auto &kv : *var)
+        {
+            map_item(a, "key", const_cast< K* >(&kv.first)); // not modified when writing
+            map_item(a, "val", &kv.second);
+        }
+    }
+    else
+    {
+        var->clear();
+        map_reserve(*var, sz);
+        for(size_t i = 0; i < sz; ++i)
+        {
+            K k{};
+            V v{};
+            map_item(a, "key", &k);
+            map_item(a, "val", &v);
+            var->emplace_hint(var->end(), std::move(k), std::move(v));
+        }
+    }
+}
+
+} // namespace detail
+
+template< class K, class V, class C, class A, class Stream >
+void serialize(Archive< Stream > &a, const char *name, std::map< K, V, C, A > *var)
+{
+    detail::serialize_map(a, var, std::integral_constant< bool, detail::map_is_bulk< std::map< K, V, C, A > >::value >());
+}
+
+template< class K, class V, class H, class E, class A, class Stream >
+void serialize(Archive< Stream > &a, const char *name, std::unordered_map< K, V, H, E, A > *var)
+{
+    detail::serialize_map(a, var, std::integral_constant< bool, detail::map_is_bulk< std::unordered_map< K, V, H, E, A > >::value >());
+}
+
+} // namespace c4
+
+#endif // _C4_SERIALIZE_STD_HPP_
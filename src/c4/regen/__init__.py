@@ -1 +1,2 @@
 from .main import *
+from .enum_utils import *
@@ -382,6 +382,31 @@ def underlying_type(enum_cursor):
     raise Exception("not implemented")
 
 
+def is_unsigned_type(t):
+    """is this an unsigned integer type? Typedefs (eg uint32_t) are
+    resolved to their canonical type."""
+    tk = clang.cindex.TypeKind
+    return t.get_canonical().kind in (tk.BOOL, tk.CHAR_U, tk.UCHAR, tk.CHAR16,
+                                      tk.CHAR32, tk.USHORT, tk.UINT, tk.ULONG,
+                                      tk.ULONGLONG, tk.UINT128)
+
+
+def is_bitwise_type(t):
+    """are the bytes of this type all of its value, so that it can be
+    copied with memcpy()? ie, is it an arithmetic or enum type, or a C
+    array of those? Typedefs (eg uint32_t) are resolved to their
+    canonical type."""
+    tk = clang.cindex.TypeKind
+    t = t.get_canonical()
+    while t.kind == tk.CONSTANTARRAY:
+        t = t.element_type.get_canonical()
+    return t.kind in (tk.BOOL, tk.CHAR_U, tk.UCHAR, tk.CHAR16, tk.CHAR32,
+                      tk.USHORT, tk.UINT, tk.ULONG, tk.ULONGLONG, tk.UINT128,
+                      tk.CHAR_S, tk.SCHAR, tk.WCHAR, tk.SHORT, tk.INT,
+                      tk.LONG, tk.LONGLONG, tk.INT128, tk.FLOAT, tk.DOUBLE,
+                      tk.ENUM)
+
+
 # ------------------------------------------------------------------------------
 # ------------------------------------------------------------------------------
 # ------------------------------------------------------------------------------
@@ -429,15 +454,32 @@ def get_comment_same_line(cursor):
 
 
 def get_comment_tokens(trans_unit, at_line=None, outside_of_cursor=None):
+    if at_line is not None:
+        return list(_get_comment_lines(trans_unit).get(at_line, []))
     l = []
     for t in trans_unit.cursor.get_tokens():
-        if at_line is None or straddles(t, at_line):
-            if outside_of_cursor is None or outside_of_cursor:
-                if t.kind == clang.cindex.TokenKind.COMMENT:
-                    l.append(t)
+        if outside_of_cursor is None or outside_of_cursor:
+            if t.kind == clang.cindex.TokenKind.COMMENT:
+                l.append(t)
     return l
 
 
+def _get_comment_lines(trans_unit):
+    """get a dict mapping each line to the comment tokens straddling it.
+    This is built only once per translation unit, so that looking up the
+    comments of each entity does not need a pass over all the tokens."""
+    lines = getattr(trans_unit, '_c4_comment_lines', None)
+    if lines is None:
+        lines = {}
+        for t in trans_unit.cursor.get_tokens():
+            if t.kind == clang.cindex.TokenKind.COMMENT:
+                e = t.extent
+                for l in range(e.start.line, e.end.line + 1):
+                    lines.setdefault(l, []).append(t)
+        trans_unit._c4_comment_lines = lines
+    return lines
+
+
 # ------------------------------------------------------------------------------
 # ------------------------------------------------------------------------------
 # ------------------------------------------------------------------------------
@@ -0,0 +1,579 @@
+"""
+Utilities for building the lookup tables that are emitted by the enum
+generator. The hashing functions here MUST be kept in sync with their
+C++ counterparts in examples/common/include/enum.hpp.
+"""
+
+import bisect
+import os.path
+
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+
+def emix(h):
+    """the final avalanche from murmur3 (fmix32). Same as emix() in enum.hpp"""
+    h &= 0xffffffff
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & 0xffffffff
+    h ^= h >> 13
+    h = (h * 0xc2b2ae35) & 0xffffffff
+    h ^= h >> 16
+    return h
+
+
+def ehash(s, seed=0):
+    """32 bit FNV-1a of a string, followed by emix().
+    Same as ehash() in enum.hpp"""
+    if isinstance(s, str):
+        s = s.encode('utf-8')
+    h = (2166136261 ^ seed) & 0xffffffff
+    for c in s:
+        h ^= c
+        h = (h * 16777619) & 0xffffffff
+    return emix(h)
+
+
+def next_pow2(n):
+    p = 1
+    while p < n:
+        p <<= 1
+    return p
+
+
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+
+def name_variants(name, class_offset, prefix_offset):
+    """get the spellings accepted for an enum symbol name: the full name,
+    the name without the enum class and the name without the prefix.
+    These are the same as accepted by EnumSymbols::Sym::cmp().
+    Returns a list of (offset, string) tuples, without repetitions
+    or empty strings."""
+    l = []
+    for o in (0, class_offset, prefix_offset):
+        if o < len(name) and (o, name[o:]) not in l:
+            l.append((o, name[o:]))
+    return l
+
+
+class EnumPerfectHash:
+    """
+    A collision-free (perfect) hash of the spellings of the symbols of
+    an enum, using the hash-and-displace method. A name is looked up as
+    follows (see EnumSymbols::find() in enum.hpp):
+
+        h = ehash(name, seed)
+        bucket = h & (num_buckets - 1)
+        slot = emix(h ^ disp[bucket]) & (num_slots - 1)
+
+    and is then compared only against the symbol which is in that slot.
+    """
+
+    max_seeds = 64
+    max_disp = 1 << 16
+
+    def __init__(self, symbol_names, class_offset=0, prefix_offset=0):
+        """
+        :param symbol_names: the list of (full) symbol names
+        :param class_offset: length of the enum class part of the names
+        :param prefix_offset: length of the enum class plus common prefix
+        """
+        # gather the keys. For repeated spellings, the first symbol wins
+        # (the same as with the linear search)
+        self.keys = []  # list of (string, symbol index, offset)
+        seen = set()
+        for i, n in enumerate(symbol_names):
+            for o, s in name_variants(n, class_offset, prefix_offset):
+                if s in seen:
+                    continue
+                seen.add(s)
+                self.keys.append((s, i, o))
+        n = max(1, len(self.keys))
+        self.num_buckets = next_pow2((n + 3) // 4)
+        self.num_slots = next_pow2(n)
+        while True:
+            for seed in range(__class__.max_seeds):
+                if self._build(seed):
+                    return
+            self.num_slots *= 2
+
+    def _build(self, seed):
+        hashes = [ehash(k[0], seed) for k in self.keys]
+        if len(set(hashes)) != len(hashes):
+            return False
+        bmask = self.num_buckets - 1
+        smask = self.num_slots - 1
+        buckets = [[] for _ in range(self.num_buckets)]
+        for i, h in enumerate(hashes):
+            buckets[h & bmask].append(i)
+        order = sorted(range(self.num_buckets), key=lambda b: -len(buckets[b]))
+        disp = [0] * self.num_buckets
+        slots = [None] * self.num_slots
+        for b in order:
+            bkeys = buckets[b]
+            if not bkeys:
+                break
+            for d in range(__class__.max_disp):
+                pos = [emix(hashes[k] ^ d) & smask for k in bkeys]
+                if (len(set(pos)) == len(pos)
+                    and all(slots[p] is None for p in pos)):
+                    break
+            else:
+                return False
+            disp[b] = d
+            for k, p in zip(bkeys, pos):
+                slots[p] = k
+        self.seed = seed
+        self.disp = disp
+        self.slots = [None if k is None else self.keys[k] for k in slots]
+        return True
+
+    def find(self, s):
+        """look up a string. Returns the symbol index, or None"""
+        h = ehash(s, self.seed)
+        d = self.disp[h & (self.num_buckets - 1)]
+        k = self.slots[emix(h ^ d) & (self.num_slots - 1)]
+        if k is None or k[0] != s:
+            return None
+        return k[1]
+
+    @property
+    def ctx(self):
+        return {
+            'seed': self.seed,
+            'num_buckets': self.num_buckets,
+            'num_slots': self.num_slots,
+            'disp': self.disp,
+            'slots': [
+                {'sym': 0, 'offs': 0, 'len': 0} if k is None else
+                {'sym': k[1], 'offs': k[2], 'len': len(k[0])}
+                for k in self.slots
+            ],
+        }
+
+
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+
+class EnumValueIndex:
+    """
+    A table to find the symbol of an enum value, without scanning the
+    symbols. For repeated values, the first symbol wins (the same as
+    with the linear search). Depending on the values, the table is one of:
+
+    * dense: the values span a range which is at most max_holes_ratio
+      bigger than the number of distinct values. The table has the symbol
+      index of each value in [min, min+num), with empty entries set to
+      EnumValueIndex.empty. When the symbols are declared in the order of
+      their values (eg, 0, 1, 2, ...) there is no need for a table, and
+      the symbols are indexed directly.
+    * sorted: the indices of all the symbols, sorted by value, for
+      binary search.
+    """
+
+    empty = 0xffffffff
+    max_holes_ratio = 2
+
+    def __init__(self, values):
+        self.min = 0
+        self.num = 0
+        self.table = []
+        first = {}
+        for i, v in enumerate(values):
+            if v not in first:
+                first[v] = i
+        if not first:
+            return
+        vmin, vmax = min(first), max(first)
+        span = vmax - vmin + 1
+        if span <= __class__.max_holes_ratio * len(first) and span < (1 << 32):
+            self.min = vmin
+            self.num = span
+            if values != list(range(vmin, vmin + span)):
+                e = __class__.empty
+                self.table = [first.get(v, e) for v in range(vmin, vmin + span)]
+        else:
+            self.table = sorted(range(len(values)), key=lambda i: (values[i], i))
+
+    @property
+    def is_dense(self):
+        return self.num > 0
+
+    def find(self, value, values):
+        """look up a value. Returns the symbol index, or None"""
+        if self.is_dense:
+            d = value - self.min
+            if d < 0 or d >= self.num:
+                return None
+            i = self.table[d] if self.table else d
+            return None if i == __class__.empty else i
+        sorted_values = [values[i] for i in self.table]
+        pos = bisect.bisect_left(sorted_values, value)
+        if pos < len(sorted_values) and sorted_values[pos] == value:
+            return self.table[pos]
+        return None
+
+    @property
+    def ctx(self):
+        return {
+            'dense': self.is_dense,
+            'min': self.min,
+            'num': self.num,
+            'table': self.table,
+        }
+
+
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+
+class EnumDenseIndex:
+    """
+    Maps the distinct values of an enum to the dense range [0, num), in
+    the order of the values, for eindex()/evalue() and the containers
+    indexed by enum. For repeated values, the first symbol wins. When
+    the values are contiguous, the index is the value minus the smallest
+    value; otherwise, the generated code switches on the value.
+    """
+
+    def __init__(self, values):
+        first = {}
+        for i, v in enumerate(values):
+            if v not in first:
+                first[v] = i
+        self.values = sorted(first)
+        self.syms = [first[v] for v in self.values]
+        self.num = len(self.values)
+        self.min = self.values[0] if self.values else 0
+        self.contiguous = (self.values == list(range(self.min, self.min + self.num)))
+
+    def find(self, value):
+        """get the index of a value, or None"""
+        pos = bisect.bisect_left(self.values, value)
+        if pos < self.num and self.values[pos] == value:
+            return pos
+        return None
+
+    @property
+    def ctx(self):
+        return {
+            'num': self.num,
+            'min': self.min,
+            'contiguous': self.contiguous,
+            'syms': self.syms,
+        }
+
+
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+
+def popcount(v):
+    return bin(v).count('1')
+
+
+class EnumBitmaskIndex:
+    """
+    Tables to decompose a bitmask into the symbols of its enum, without
+    scanning all the symbols. Only for enums detected as bitmasks: every
+    nonzero value is either a single bit or a union of the single bits
+    of other symbols (a composite, eg BM_FOO_BAR=BM_FOO|BM_BAR), there
+    are at least two single bits, and at most max_composites_ratio times
+    as many composites as single bits. The tables are:
+
+    * composites: the indices of the composite symbols, by decreasing
+      popcount. These are tried first, so that a composite is preferred
+      to its bits.
+    * bits: for each bit up to the highest single bit, the index of the
+      symbol with that bit as value, or EnumBitmaskIndex.empty.
+
+    For repeated values, the last symbol wins (the same as with the
+    reverse scan done by bm2str() when there are no tables). Small enums
+    with consecutive values (eg 0, 1, 2) are also taken as bitmasks;
+    this is harmless, as the decomposition is the same, and the tables
+    are small.
+    """
+
+    empty = 0xffffffff
+    max_composites_ratio = 2
+
+    def __init__(self, values, num_bits):
+        """
+        :param values: the values of the symbols
+        :param num_bits: the number of bits of the underlying type
+        """
+        self.num_bits = num_bits
+        self.composites = []
+        self.bits = []
+        mask = (1 << num_bits) - 1
+        self.values = [v & mask for v in values]  # two's complement
+        e = __class__.empty
+        bits = [e] * num_bits
+        composites = []
+        for i in reversed(range(len(self.values))):
+            v = self.values[i]
+            if v == 0:
+                continue
+            elif v & (v - 1) == 0:
+                b = v.bit_length() - 1
+                if bits[b] == e:
+                    bits[b] = i
+            else:
+                composites.append(i)
+        single = 0
+        for b, i in enumerate(bits):
+            if i != e:
+                single |= 1 << b
+        num_single = popcount(single)
+        if num_single < 2:
+            return
+        if len(composites) > __class__.max_composites_ratio * num_single:
+            return
+        if any(self.values[i] & ~single for i in composites):
+            return
+        # sort() is stable: equal popcounts stay in reverse order
+        composites.sort(key=lambda i: -popcount(self.values[i]))
+        self.composites = composites
+        self.bits = bits[:single.bit_length()]
+
+    @property
+    def is_bitmask(self):
+        return len(self.bits) > 0
+
+    def decompose(self, value):
+        """get the indices of the symbols making up a value, ordered by
+        their lowest bit. Returns None if some bit has no symbol. Same as
+        bm2str() in bitmask.hpp"""
+        assert self.is_bitmask
+        value &= (1 << self.num_bits) - 1
+        l = []
+        if popcount(value) > 1:
+            for i in self.composites:
+                c = self.values[i]
+                if value & c == c:
+                    l.append(i)
+                    value &= ~c
+        while value:
+            b = (value & -value).bit_length() - 1
+            if b >= len(self.bits) or self.bits[b] == __class__.empty:
+                return None
+            l.append(self.bits[b])
+            value &= value - 1
+        return sorted(l, key=lambda i: self.values[i] & -self.values[i])
+
+    def lut(self, names):
+        """get the lookup tables to format masks of single bits a byte at
+        a time: for each byte of the mask (up to the highest single bit)
+        and for each of its 256 values, the names of the bits set, joined
+        by '|'. Bits with no symbol are left out. The table of the last
+        byte only has the values up to the highest single bit.
+
+        :param names: the names of the symbols, as they are to be written
+        :return: a dict with the number of bytes, the fragments, the offset
+            of each fragment in their concatenation (plus the total size
+            at the end) and the mask of the bits having a symbol
+        """
+        assert self.is_bitmask
+        e = __class__.empty
+        num_bytes = (len(self.bits) + 7) // 8
+        bit_names = [names[i] if i != e else None for i in self.bits]
+        bit_names += [None] * (8 * num_bytes - len(bit_names))
+        fragments = []
+        offs = []
+        pos = 0
+        for k in range(num_bytes):
+            for v in range(1 << min(8, len(self.bits) - 8 * k)):
+                f = '|'.join(bit_names[8 * k + j] for j in range(8)
+                             if (v >> j) & 1 and bit_names[8 * k + j] is not None)
+                fragments.append(f)
+                offs.append(pos)
+                pos += len(f)
+        offs.append(pos)
+        mask = 0
+        for b, i in enumerate(self.bits):
+            if i != e:
+                mask |= 1 << b
+        return {
+            'num_bytes': num_bytes,
+            'fragments': fragments,
+            'offs': offs,
+            'mask': mask,
+        }
+
+    @property
+    def ctx(self):
+        return {
+            'is_bitmask': self.is_bitmask,
+            'composites': self.composites,
+            'bits': self.bits,
+        }
+
+
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+
+class EnumNamePool:
+    """
+    A single string blob with the (null-terminated) names of the symbols
+    of all the enums in a source file, so that the symbols can refer to
+    their names by offset instead of by pointer. A name which is a suffix
+    of another name is not stored again; it points into the longer name.
+    """
+
+    def __init__(self, names, var='esyms_names'):
+        """
+        :param names: the names to place in the pool. Repetitions are fine.
+        :param var: the name of the C++ variable holding the pool
+        """
+        self.var = var
+        # sorting by the reversed strings puts each string right before
+        # the strings of which it is a suffix
+        owner = {}  # name -> the stored string having the name as suffix
+        longest = None
+        for r in sorted(set(n[::-1] for n in names), reverse=True):
+            if longest is None or not longest.startswith(r):
+                longest = r
+            owner[r[::-1]] = longest[::-1]
+        # place the stored strings in order of first appearance
+        self.strings = []
+        self.pos = {}
+        self.size = 0
+        for n in names:
+            s = owner[n]
+            if s not in self.pos:
+                self.strings.append(s)
+                self.pos[s] = self.size
+                self.size += len(s) + 1
+            self.pos[n] = self.pos[s] + len(s) - len(n)
+
+    def find(self, name):
+        """get the offset of a name in the pool"""
+        return self.pos[name]
+
+    @property
+    def ctx(self):
+        return {
+            'var': self.var,
+            'size': self.size,
+            'strings': self.strings,
+            'pos': self.pos,
+        }
+
+
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+# ------------------------------------------------------------------------------
+
+class EnumNameTrie:
+    """
+    A trie of the spellings of the symbols of an enum, to be emitted as
+    code: a switch on the length of the name, then switches on the
+    characters where the spellings diverge, and memcmp() on the runs of
+    characters which are common. This needs no table data, and the
+    compiler can turn the switches into jump tables.
+    """
+
+    none = 0xffffffff
+
+    def __init__(self, symbol_names, class_offset=0, prefix_offset=0):
+        """
+        :param symbol_names: the list of (full) symbol names
+        :param class_offset: length of the enum class part of the names
+        :param prefix_offset: length of the enum class plus common prefix
+        """
+        # for repeated spellings, the first symbol wins
+        keys = {}
+        for i, n in enumerate(symbol_names):
+            for o, s in name_variants(n, class_offset, prefix_offset):
+                keys.setdefault(s, i)
+        by_len = {}
+        for s, i in keys.items():
+            by_len.setdefault(len(s), []).append((s, i))
+        self.root = {l: __class__._build(sorted(ks), 0)
+                     for l, ks in sorted(by_len.items())}
+
+    @staticmethod
+    def _build(keys, depth):
+        """the nodes are tuples:
+            ('leaf', depth, rest, sym) : compare the rest of the string
+            ('run', depth, run, child) : compare a run common to all strings
+            ('switch', depth, [(char, child)...]) : switch on a character
+        """
+        if len(keys) == 1:
+            s, i = keys[0]
+            return ('leaf', depth, s[depth:], i)
+        common = os.path.commonprefix([k[0] for k in keys])
+        if len(common) > depth:
+            return ('run', depth, common[depth:],
+                    __class__._build(keys, len(common)))
+        cases = []
+        for k in keys:
+            c = k[0][depth]
+            if not cases or cases[-1][0] != c:
+                cases.append((c, []))
+            cases[-1][1].append(k)
+        return ('switch', depth,
+                [(c, __class__._build(ks, depth + 1)) for c, ks in cases])
+
+    def find(self, s):
+        """look up a string. Returns the symbol index, or None"""
+        n = self.root.get(len(s))
+        while n is not None:
+            if n[0] == 'leaf':
+                return n[3] if s[n[1]:] == n[2] else None
+            elif n[0] == 'run':
+                if s[n[1]:n[1]+len(n[2])] != n[2]:
+                    return None
+                n = n[3]
+            else:
+                n = dict(n[2]).get(s[n[1]])
+        return None
+
+    def code(self, indent=0):
+        """get the C++ code for the body of a function with arguments
+        (const char *s, size_t len), returning the symbol index or
+        EnumNameTrie.none"""
+        lines = ["const uint32_t none = {:#x};".format(__class__.none),
+                 "switch(len)", "{"]
+        for l, n in self.root.items():
+            lines.append("case {}:".format(l))
+            __class__._code(n, lines, 1)
+        lines += ["default:", "    return none;", "}"]
+        pad = " " * indent
+        return "\n".join(pad + ln for ln in lines)
+
+    @staticmethod
+    def _cmp(depth, run, op):
+        """C++ expression comparing the chars at depth to run"""
+        if len(run) == 1:
+            return "s[{}] {} '{}'".format(depth, op, run)
+        p = "s + {}".format(depth) if depth else "s"
+        return 'memcmp({}, "{}", {}) {} 0'.format(p, run, len(run), op)
+
+    @staticmethod
+    def _code(n, lines, level):
+        c = __class__
+        pad = "    " * level
+        if n[0] == 'leaf':
+            d, rest, i = n[1], n[2], n[3]
+            if rest:
+                lines.append('{}return {} ? {} : none;'.format(pad, c._cmp(d, rest, '=='), i))
+            else:
+                lines.append('{}return {};'.format(pad, i))
+        elif n[0] == 'run':
+            lines.append('{}if({})'.format(pad, c._cmp(n[1], n[2], '!=')))
+            lines.append('{}    return none;'.format(pad))
+            c._code(n[3], lines, level)
+        else:
+            lines.append('{}switch(s[{}])'.format(pad, n[1]))
+            lines.append('{}{{'.format(pad))
+            for ch, child in n[2]:
+                lines.append("{}case '{}':".format(pad, ch))
+                c._code(child, lines, level + 1)
+            lines.append('{}default:'.format(pad))
+            lines.append('{}    return none;'.format(pad))
+            lines.append('{}}}'.format(pad))
@@ -6,6 +6,7 @@ import os.path
 
 from . import util
 from .util import dbg
+from .enum_utils import ehash, EnumPerfectHash, EnumValueIndex, EnumDenseIndex, EnumBitmaskIndex, EnumNamePool, EnumNameTrie
 
 # ------------------------------------------------------------------------------
 # ------------------------------------------------------------------------------
@@ -187,6 +188,26 @@ class Prop(Member):
             raise Exception(str(self) + ": could not find class!!!")
 
 
+def field_id(name):
+    """the id of a member in archives with field tags: the hash of its
+    name. Same as detail::field_id() in serialize.hpp"""
+    return ehash(name)
+
+
+def field_ids(owner, names):
+    """the field ids of the given members of a class. Archives with field
+    tags find the members by id alone, so two members whose names hash to
+    the same id are an error; rename one of them."""
+    ids = [field_id(n) for n in names]
+    seen = {}
+    for n, i in zip(names, ids):
+        if i in seen:
+            raise Exception("{}: the members {} and {} have the same field id {}"
+                            .format(owner, seen[i], n, i))
+        seen[i] = n
+    return ids
+
+
 # ------------------------------------------------------------------------------
 # ------------------------------------------------------------------------------
 # ------------------------------------------------------------------------------
@@ -230,12 +251,44 @@ class Class(CodeEntity):
             if m is not None:
                 self.members.append(m)
         #print(self)#, self.props, self.members)
+        self.is_bitwise = self._is_bitwise()
         self.ctx = self._ctx()
 
+    def _is_bitwise(self):
+        """can the class be copied with a single memcpy() instead of
+        member by member? ie, is it a pod without padding, whose fields
+        are exactly the members found here, in order, all of them of
+        arithmetic or enum types (or C arrays of those)? Templates are
+        never bitwise, as their member types are not known."""
+        self.offsets = None
+        if self.is_template:
+            return False
+        t = self.class_cursor.type
+        if not t.is_pod():
+            return False
+        fields = [c for c in self.class_cursor.get_children()
+                  if c.kind in (ck.FIELD_DECL, ck.CXX_BASE_SPECIFIER)]
+        if [f.displayname for f in fields] != [m.name for m in self.members]:
+            return False
+        size = 0
+        offsets = []
+        for f in fields:
+            if (f.kind != ck.FIELD_DECL or f.is_bitfield()
+                or not clu.is_bitwise_type(f.type)
+                or t.get_offset(f.spelling) != 8 * size):
+                return False
+            offsets.append(size)
+            size += f.type.get_size()
+        if size != t.get_size():
+            return False
+        self.offsets = offsets
+        return True
+
     def _ctx(self):
         ctx = {
             'type': self.name,
             'is_tpl': self.is_template,
+            'is_bitwise': self.is_bitwise,
             'tpl_params': self.tpl_params,
             'tpl_param_names': self.tpl_param_names,
             'type_without_tpl_params': self.name_without_template_params,
@@ -248,10 +301,13 @@ class Class(CodeEntity):
                 'name': p.name
             }
             ctx['props'].append(d)
-        for m in self.members:
+        ids = field_ids(self.name, [m.name for m in self.members])
+        for i, m in enumerate(self.members):
             d = {
                 'type': m.type_name,
-                'name': m.name
+                'name': m.name,
+                'id': ids[i],
+                'offset': self.offsets[i] if self.offsets else None,
             }
             ctx['members'].append(d)
         return ctx
@@ -291,6 +347,7 @@ class Enum(CodeEntity):
         self.macro = Annotation(macro_cursor)
         self.enum_cursor = self._find_enum_node(macro_cursor)
         self.underlying_type = self.enum_cursor.enum_type.spelling
+        self.underlying_bits = 8 * self.enum_cursor.enum_type.get_size()
         super().__init__(self.enum_cursor)
         #
         # is this enum a C++1x enum class?
@@ -312,6 +369,12 @@ class Enum(CodeEntity):
                 if enclosing_class:
                     es.name = self.enclosing_class_name + "::" + es.name
                 self.symbols.append(es)
+        # libclang gives the values of enums with a typedef'd unsigned
+        # type (eg uint32_t) as signed. Fix them.
+        if clu.is_unsigned_type(self.enum_cursor.enum_type):
+            mask = (1 << self.underlying_bits) - 1
+            for s in self.symbols:
+                s.value &= mask
 
         self.symbol_prefix = os.path.commonprefix([s.name for s in self.symbols])
 
@@ -323,10 +386,15 @@ class Enum(CodeEntity):
         enccn = (self.enclosing_class_name + "::") if self.enclosing_class_name else ""
         #print(enccn)
         ename = enccn + self.enum_name
+        names = [cn + s.name for s in self.symbols]
+        for n in names:
+            __class__._check_sym_len(n)
+        dense_index = EnumDenseIndex([s.value for s in self.symbols])
         self._ctx = {
             'enum':{
                 'type': ename,
                 'underlying_type': self.underlying_type,
+                'underlying_bits': self.underlying_bits,
                 'comment': self.comment,
                 'is_class': self.is_class,
                 'class': self.class_name,
@@ -340,12 +408,19 @@ class Enum(CodeEntity):
                 'ast_node': self.enum_cursor,
                 'symbols': [
                     {
-                        'name': cn + s.name,
+                        'name': n,
                         'value': s.value,
                         'comment': s.comment,
                         'ast_node': s.ast_node,
-                    } for s in self.symbols
-                ]
+                    } for n, s in zip(names, self.symbols)
+                ],
+                'phash': EnumPerfectHash(names, len(cn),
+                                         len(cn) + len(self.symbol_prefix)).ctx,
+                'value_index': EnumValueIndex([s.value for s in self.symbols]).ctx,
+                'dense_index': dict(dense_index.ctx,
+                                    names=[names[i] for i in dense_index.syms]),
+                'bitmask': EnumBitmaskIndex([s.value for s in self.symbols],
+                                            self.underlying_bits).ctx,
             }
         }
         return self._ctx
@@ -546,15 +621,340 @@ class ClassGenerator(BaseGenerator):
 # -----------------------------------------------------------------------------
 # -----------------------------------------------------------------------------
 class EnumGenerator(BaseGenerator):
+    """
+    Generates code for the enums tagged with C4_ENUM. When none of the
+    hdr, src or inl templates are given, the built-in templates are used;
+    these implement esyms< T >() and friends for the enum.hpp header found
+    in the examples folder. The built-in templates accept these options:
+
+    :param storage: where the symbol tables are placed. 'src' declares
+        esyms() in the header and defines it in the source file.
+        'inl' defines esyms() inline, in the header. 'constexpr' places
+        the tables in the header as static constexpr data of
+        esyms_data< T >, and defines esyms() inline, so that the compiler
+        can inline and constant-fold calls such as e2str(MyEnum::FOO).
+        Before C++17, the source file gets the definitions of the tables;
+        from C++17 on, these are inline variables and the source file is
+        not needed.
+    :param str2e: how the names are looked up. 'phash' emits a perfect
+        hash of the names, making str2e() O(1). 'trie' emits a function
+        with nested switches on the length and on the characters of the
+        names, which needs no table data. 'linear' emits no tables,
+        making str2e() a linear search.
+    :param e2str: how the values are looked up. 'table' emits a table
+        indexed by value when the values are dense, making e2str() O(1),
+        or a table sorted by value otherwise, making e2str() O(log N).
+        'linear' emits no tables, making e2str() a linear search.
+    :param bitmask: how bitmasks are decomposed into symbols by bm2str().
+        'table' emits, for the enums detected as bitmasks (see
+        EnumBitmaskIndex), the composite symbols sorted by popcount and
+        a table with the symbol of each bit, so that the cost depends on
+        the number of bits set instead of on the number of symbols.
+        'lut' emits these tables, plus a table per byte of the mask with
+        the names (without prefix) of the bits set in each of its 256
+        values, joined by '|'. bm2str() then formats masks of single
+        bits with one lookup and one memcpy() per byte. These tables are
+        big: for 32 bits and names of 8 characters, about 40KB.
+        'linear' emits no tables, making bm2str() scan all the symbols.
+    :param names: how the symbols refer to their names. 'literal' gives
+        each symbol a pointer to its own string literal. 'pool' packs the
+        names of all the enums in a source file into a single string, and
+        the symbols refer to their names by offset into it; this saves a
+        relocation per symbol, and keeps the names close in memory.
+        Requires storage='src'.
+    """
+
+    storage_types = ('src', 'inl', 'constexpr')
+    str2e_types = ('phash', 'trie', 'linear')
+    e2str_types = ('table', 'linear')
+    bitmask_types = ('table', 'lut', 'linear')
+    names_types = ('literal', 'pool')
 
     def __init__(self, **kwargs):
         kwargs['name'] = kwargs.get('name', 'enum')
+        self.opts = {
+            'storage': kwargs.get('storage', 'src'),
+            'str2e': kwargs.get('str2e', 'phash'),
+            'e2str': kwargs.get('e2str', 'table'),
+            'bitmask': kwargs.get('bitmask', 'table'),
+            'names': kwargs.get('names', 'literal'),
+        }
+        c = __class__
+        c._check_opt('storage', self.opts, c.storage_types)
+        c._check_opt('str2e', self.opts, c.str2e_types)
+        c._check_opt('e2str', self.opts, c.e2str_types)
+        c._check_opt('bitmask', self.opts, c.bitmask_types)
+        c._check_opt('names', self.opts, c.names_types)
+        if self.opts['names'] == 'pool' and self.opts['storage'] != 'src':
+            raise Exception("names=pool requires storage=src")
+        if not (kwargs.get('hdr') or kwargs.get('src') or kwargs.get('inl')):
+            if self.opts['storage'] == 'src':
+                kwargs['hdr'] = c.tpl_decl + c.tpl_offs + c.tpl_eindex
+                kwargs['src'] = c.tpl_def
+            elif self.opts['storage'] == 'inl':
+                kwargs['inl'] = c.tpl_def + c.tpl_offs + c.tpl_eindex
+            else:
+                kwargs['hdr'] = c.tpl_constexpr_hdr + c.tpl_offs + c.tpl_eindex
+                kwargs['src'] = c.tpl_constexpr_src
         super().__init__(**kwargs)
 
-    def gen_code(self, c4enum):
-        ctx = c4enum.ctx
+    def gen_chunks(self, source_file, enums):
+        """generate the chunks for all the enums in a source file"""
+        chunks = []
+        name_pool = None
+        if self.opts['names'] == 'pool' and enums:
+            names = [s['name'] for e in enums for s in e.ctx['enum']['symbols']]
+            var = 'esyms_names_' + re.sub(r'\W', '_', os.path.basename(source_file.filename))
+            name_pool = EnumNamePool(names, var)
+            src = tpl_env.from_string(__class__.tpl_pool).render(name_pool.ctx)
+            chunks.append(CodeChunk(self, enums[0], src='\n' + src))
+        for e in enums:
+            chunks.append(self.gen_code(e, name_pool))
+        return chunks
+
+    def gen_code(self, c4enum, name_pool=None):
+        ctx = dict(c4enum.ctx)
+        ctx['opts'] = self.opts
+        e = ctx['enum']
+        ctx['has_bitmask'] = self.opts['bitmask'] != 'linear' and e['bitmask']['is_bitmask']
+        if ctx['has_bitmask'] and self.opts['bitmask'] == 'lut':
+            bi = EnumBitmaskIndex([s['value'] for s in e['symbols']], e['underlying_bits'])
+            ctx['bitmask_lut'] = bi.lut([s['name'][e['prefix_offset']:] for s in e['symbols']])
+        ctx['has_index'] = (self.opts['str2e'] != 'linear' or
+                            self.opts['e2str'] != 'linear' or
+                            ctx['has_bitmask'])
+        if name_pool is not None:
+            ctx['name_pool'] = name_pool.ctx
+        if self.opts['str2e'] == 'trie':
+            names = [s['name'] for s in e['symbols']]
+            trie = EnumNameTrie(names, e['class_offset'], e['prefix_offset'])
+            ctx['name_trie'] = trie.code(indent=12)
         return self._gen(c4enum, ctx)
 
+    @staticmethod
+    def _check_opt(name, opts, allowed):
+        if opts[name] not in allowed:
+            msg = "{}: invalid value for {}. Must be one of {}"
+            raise Exception(msg.format(opts[name], name, ",".join(allowed)))
+
+    tpl_decl = """\
+template<> const EnumSymbols< {{enum.type}} > esyms();
+"""
+
+    tpl_offs = """\
+{% if enum.class_offset > 0 %}
+template<> inline size_t eoffs_cls< {{enum.type}} >()
+{
+    // same as strlen("{{enum.class_str}}")
+    return {{enum.class_offset}};
+}
+{% endif %}
+{% if enum.prefix_offset > enum.class_offset %}
+template<> inline size_t eoffs_pfx< {{enum.type}} >()
+{
+    // same as strlen("{{enum.class_str}}{{enum.prefix}}")
+    return {{enum.prefix_offset}};
+}
+{% endif %}
+"""
+
+    tpl_eindex = """\
+{% set di = enum.dense_index %}
+template<> constexpr size_t esize< {{enum.type}} >()
+{
+    return {{di.num}};
+}
+{% if di.contiguous %}
+template<> inline size_t eindex< {{enum.type}} >({{enum.type}} v)
+{
+    // the values are contiguous
+    using U = std::make_unsigned< std::underlying_type< {{enum.type}} >::type >::type;
+    U i = static_cast< U >(static_cast< U >(v) - static_cast< U >({{di.min}}ull));
+    return i < {{di.num}} ? i : {{di.num}};
+}
+template<> inline {{enum.type}} evalue< {{enum.type}} >(size_t i)
+{
+    using U = std::make_unsigned< std::underlying_type< {{enum.type}} >::type >::type;
+    C4_XASSERT(i < {{di.num}});
+    return static_cast< {{enum.type}} >(static_cast< U >(static_cast< U >({{di.min}}ull) + static_cast< U >(i)));
+}
+{% else %}
+template<> inline size_t eindex< {{enum.type}} >({{enum.type}} v)
+{
+    switch(v)
+    {
+    {% for n in di.names %}
+    case {{n}}: return {{loop.index0}};
+    {% endfor %}
+    default: return {{di.num}};
+    }
+}
+template<> inline {{enum.type}} evalue< {{enum.type}} >(size_t i)
+{
+    static const {{enum.type}} vals[] = {
+        {% for row in di.names|batch(4) %}
+        {{row|join(', ')}},
+        {% endfor %}
+    };
+    C4_XASSERT(i < {{di.num}});
+    return vals[i];
+}
+{% endif %}
+"""
+
+    tpl_tables = """\
+{% set decl = 'static constexpr' if opts.storage == 'constexpr' else 'static const' %}
+{% if opts.names == 'pool' %}
+    {{decl}} EnumSymbols< {{enum.type}} >::PooledSym pooled[] = {
+        {% for e in enum.symbols %}
+        { {{e.name}}, {{name_pool.pos[e.name]}}, {{e.name|length}}, {{enum.class_offset}}, {{enum.prefix_offset}}},
+        {% endfor %}
+    };
+    static const auto vals = EnumSymbols< {{enum.type}} >::unpool(pooled, {{name_pool.var}});
+{% else %}
+    {{decl}} EnumSymbols< {{enum.type}} >::Sym vals[] = {
+        {% for e in enum.symbols %}
+        { {{e.name}}, "{{e.name}}", {{e.name|length}}, {{enum.class_offset}}, {{enum.prefix_offset}}},
+        {% endfor %}
+    };
+{% endif %}
+{% if opts.str2e == 'phash' %}
+    {{decl}} uint32_t hash_disp[] = {
+        {% for row in enum.phash.disp|batch(16) %}
+        {{row|join(', ')}},
+        {% endfor %}
+    };
+    {{decl}} EnumSymbols< {{enum.type}} >::NameSlot hash_slots[] = {
+        {% for sl in enum.phash.slots %}
+        { {{sl.sym}}, {{sl.offs}}, {{sl.len}}},
+        {% endfor %}
+    };
+{% endif %}
+{% if opts.str2e == 'trie' %}
+    struct name_trie
+    {
+        static uint32_t find(const char *s, size_t len)
+        {
+{{name_trie}}
+        }
+    };
+{% endif %}
+{% if opts.e2str == 'table' and enum.value_index.table %}
+    {{decl}} uint32_t val_syms[] = {
+        {% for row in enum.value_index.table|batch(16) %}
+        {{row|join(', ')}},
+        {% endfor %}
+    };
+{% endif %}
+{% if has_bitmask %}
+{% if enum.bitmask.composites %}
+    {{decl}} uint32_t bm_composites[] = {
+        {% for row in enum.bitmask.composites|batch(16) %}
+        {{row|join(', ')}},
+        {% endfor %}
+    };
+{% endif %}
+    {{decl}} uint32_t bm_bits[] = {
+        {% for row in enum.bitmask.bits|batch(16) %}
+        {{row|join(', ')}},
+        {% endfor %}
+    };
+{% endif %}
+{% if bitmask_lut %}
+    // for each byte and each of its values, the names of the bits set
+    {{decl}} uint32_t bm_lut_offs[] = {
+        {% for row in bitmask_lut.offs|batch(16) %}
+        {{row|join(', ')}},
+        {% endfor %}
+    };
+    {{decl}} char bm_lut_names[] =
+        {% for row in bitmask_lut.fragments|batch(8) %}
+        "{{row|join('" "')}}"
+        {% endfor %}
+        ;
+{% endif %}
+{% if has_index %}
+    {{decl}} EnumSymbols< {{enum.type}} >::Index idx = {
+{% if opts.str2e == 'phash' %}
+        {{enum.phash.seed}}, {{enum.phash.num_buckets}}, {{enum.phash.num_slots}}, hash_disp, hash_slots,
+{% else %}
+        0, 0, 0, nullptr, nullptr,
+{% endif %}
+{% if opts.e2str == 'table' %}
+        {{enum.value_index.min}}, {{enum.value_index.num}}, {{'val_syms' if enum.value_index.table else 'nullptr'}},
+{% else %}
+        0, 0, nullptr,
+{% endif %}
+        {{'&name_trie::find' if opts.str2e == 'trie' else 'nullptr'}},
+{% if has_bitmask %}
+        {{enum.bitmask.composites|length}}, {{'bm_composites' if enum.bitmask.composites else 'nullptr'}}, {{enum.bitmask.bits|length}}, bm_bits,
+{% else %}
+        0, nullptr, 0, nullptr,
+{% endif %}
+{% if bitmask_lut %}
+        {{bitmask_lut.mask}}ull, {{bitmask_lut.num_bytes}}, bm_lut_offs, bm_lut_names,
+{% else %}
+        0, 0, nullptr, nullptr,
+{% endif %}
+    };
+{% endif %}
+"""
+
+    tpl_def = """\
+template<> {% if opts.storage == 'inl' %}inline {% endif %}const EnumSymbols< {{enum.type}} > esyms()
+{
+""" + tpl_tables + """\
+    EnumSymbols< {{enum.type}} > r(vals{{', &idx' if has_index}});
+    return r;
+}
+"""
+
+    tpl_pool = """\
+// the names of the symbols of all the enums in this file
+static const char {{var}}[] =
+{% for s in strings %}
+    "{{s}}\\0"
+{% endfor %}
+    ;
+"""
+
+    tpl_constexpr_hdr = """\
+template<> struct esyms_data< {{enum.type}} >
+{
+""" + tpl_tables + """\
+};
+template<> inline const EnumSymbols< {{enum.type}} > esyms()
+{
+    return EnumSymbols< {{enum.type}} >(esyms_data< {{enum.type}} >::vals{{', &esyms_data< ' + enum.type + ' >::idx' if has_index}});
+}
+"""
+
+    tpl_constexpr_src = """\
+#if __cplusplus < 201703L // C++17 static constexpr members are inline
+constexpr EnumSymbols< {{enum.type}} >::Sym esyms_data< {{enum.type}} >::vals[];
+{% if opts.str2e == 'phash' %}
+constexpr uint32_t esyms_data< {{enum.type}} >::hash_disp[];
+constexpr EnumSymbols< {{enum.type}} >::NameSlot esyms_data< {{enum.type}} >::hash_slots[];
+{% endif %}
+{% if opts.e2str == 'table' and enum.value_index.table %}
+constexpr uint32_t esyms_data< {{enum.type}} >::val_syms[];
+{% endif %}
+{% if has_bitmask %}
+{% if enum.bitmask.composites %}
+constexpr uint32_t esyms_data< {{enum.type}} >::bm_composites[];
+{% endif %}
+constexpr uint32_t esyms_data< {{enum.type}} >::bm_bits[];
+{% endif %}
+{% if bitmask_lut %}
+constexpr uint32_t esyms_data< {{enum.type}} >::bm_lut_offs[];
+constexpr char esyms_data< {{enum.type}} >::bm_lut_names[];
+{% endif %}
+{% if has_index %}
+constexpr EnumSymbols< {{enum.type}} >::Index esyms_data< {{enum.type}} >::idx;
+{% endif %}
+#endif
+"""
+
 
 # -----------------------------------------------------------------------------
 # -----------------------------------------------------------------------------
@@ -653,6 +1053,9 @@ class ChunkWriterGenFile:
         :param source_file: the source file
         :return: the list of files
         """
+        chunks = getattr(source_file, 'chunks', None)
+        if chunks is not None and not any(c.src for c in chunks):
+            return [source_file.name_hdr_gen]
         return [source_file.name_hdr_gen, source_file.name_src_gen]
 
     notice = """// GENERATED AUTOMATICALLY. DO NOT EDIT THIS FILE: IT WILL BE OVERWRITTEN."""
@@ -741,9 +1144,7 @@ class SourceFile:
     def gen_chunks(self, enum_generator=None, class_generators=[]):
         chunks = []
         if enum_generator:
-            for e in self.enums:
-                ch = enum_generator.gen_code(e)
-                chunks.append(ch)
+            chunks += enum_generator.gen_chunks(self, self.enums)
         if class_generators:
             for c in self.classes:
                 for g in class_generators:
@@ -405,6 +405,186 @@ ____content____
 """)
 
 
+# -----------------------------------------------------------------------------
+# -----------------------------------------------------------------------------
+# -----------------------------------------------------------------------------
+class Test3EnumTables(ut.TestCase):
+
+    def test0_ehash(self):
+        # these values were obtained from ehash() in enum.hpp
+        self.assertEqual(regen.ehash("FOO"), 1729608478)
+        self.assertEqual(regen.ehash("MyEnumClass::FOO", 7), 1377078934)
+        self.assertEqual(regen.ehash(""), 2872998923)
+
+    def test0_field_id(self):
+        # these values were obtained from detail::field_id() in serialize.hpp
+        self.assertEqual(regen.field_id("x"), 794621484)
+        self.assertEqual(regen.field_id("tsa"), 1204621452)
+        self.assertEqual(regen.field_ids("S", ["x", "tsa"]), [794621484, 1204621452])
+        # these names have the same hash
+        with self.assertRaises(Exception):
+            regen.field_ids("S", ["x", "m763399", "m1109514"])
+
+    def test1_name_variants(self):
+        v = regen.name_variants("MyBitmaskClass::BM_FOO", 16, 19)
+        self.assertEqual(v, [(0, "MyBitmaskClass::BM_FOO"), (16, "BM_FOO"), (19, "FOO")])
+        v = regen.name_variants("BM_FOO", 0, 3)
+        self.assertEqual(v, [(0, "BM_FOO"), (3, "FOO")])
+        v = regen.name_variants("FOO", 0, 0)
+        self.assertEqual(v, [(0, "FOO")])
+
+    def test2_perfect_hash(self):
+        for num in (1, 2, 3, 10, 100, 1000):
+            names = ["MyEnumClass::PFX_SYM{}".format(i) for i in range(num)]
+            ph = regen.EnumPerfectHash(names, 13, 17)
+            for i, n in enumerate(names):
+                self.assertEqual(ph.find(n), i)
+                self.assertEqual(ph.find(n[13:]), i)
+                self.assertEqual(ph.find(n[17:]), i)
+            self.assertIsNone(ph.find("PFX_"))
+            self.assertIsNone(ph.find("SYM"))
+            self.assertIsNone(ph.find(""))
+            used = [sl for sl in ph.slots if sl is not None]
+            self.assertEqual(len(used), 3 * num)
+
+    def test3_perfect_hash_repeated_spellings(self):
+        # the stripped name of the first symbol is the same as the
+        # full name of the second: the first symbol must win
+        ph = regen.EnumPerfectHash(["P_P_X", "P_X"], 0, 2)
+        self.assertEqual(ph.find("P_X"), 0)
+        self.assertEqual(ph.find("P_P_X"), 0)
+        self.assertEqual(ph.find("X"), 1)
+
+    def test4_value_index_dense(self):
+        vi = regen.EnumValueIndex([0, 1, 2, 3])
+        self.assertTrue(vi.is_dense)
+        self.assertEqual((vi.min, vi.num, vi.table), (0, 4, []))
+        vi = regen.EnumValueIndex([3, 4, 5])
+        self.assertEqual((vi.min, vi.num, vi.table), (3, 3, []))
+        # out of order
+        vi = regen.EnumValueIndex([1, 0, 2])
+        self.assertEqual((vi.min, vi.num, vi.table), (0, 3, [1, 0, 2]))
+        # repeated values: the first wins
+        vi = regen.EnumValueIndex([0, 1, 1, 2])
+        self.assertEqual((vi.min, vi.num, vi.table), (0, 3, [0, 1, 3]))
+        # with holes, eg bitmasks
+        e = regen.EnumValueIndex.empty
+        vi = regen.EnumValueIndex([0, 1, 2, 4, 3, 7])
+        self.assertEqual((vi.min, vi.num, vi.table), (0, 8, [0, 1, 2, 4, 3, e, e, 5]))
+        self.assertIsNone(vi.find(5, None))
+        self.assertIsNone(vi.find(8, None))
+        self.assertIsNone(vi.find(-1, None))
+        self.assertEqual(vi.find(7, None), 5)
+
+    def test5_value_index_sorted(self):
+        values = [-10, 1000, 100, 1000, 5]
+        vi = regen.EnumValueIndex(values)
+        self.assertFalse(vi.is_dense)
+        self.assertEqual(vi.table, [0, 4, 2, 1, 3])
+        for i, v in enumerate(values):
+            self.assertEqual(vi.find(v, values), values.index(v))
+        self.assertIsNone(vi.find(0, values))
+        self.assertIsNone(vi.find(2000, values))
+
+    def test6_name_pool(self):
+        names = ["FOO", "MyEnumClass::FOO", "BAR", "FOO_BAR", "BAR", "AR"]
+        p = regen.EnumNamePool(names)
+        # suffixes are not stored again
+        self.assertEqual(p.strings, ["MyEnumClass::FOO", "FOO_BAR"])
+        self.assertEqual(p.size, len("MyEnumClass::FOO") + len("FOO_BAR") + 2)
+        blob = "\0".join(p.strings) + "\0"
+        for n in names:
+            pos = p.find(n)
+            self.assertEqual(blob[pos:blob.index("\0", pos)], n)
+
+    def test7_name_trie(self):
+        names = ["MyBitmaskClass::BM_NONE", "MyBitmaskClass::BM_FOO",
+                 "MyBitmaskClass::BM_BAR", "MyBitmaskClass::BM_BAZ",
+                 "MyBitmaskClass::BM_FOO_BAR"]
+        t = regen.EnumNameTrie(names, 16, 19)
+        for i, n in enumerate(names):
+            for o, s in regen.name_variants(n, 16, 19):
+                self.assertEqual(t.find(s), i)
+        for s in ("", "F", "FOX", "FOOO", "BM_FO", "MyBitmaskClass::BM_QUX"):
+            self.assertIsNone(t.find(s))
+        code = t.code()
+        self.assertIn("switch(len)", code)
+        self.assertIn('memcmp(s, "MyBitmaskClass::BM_", 19) != 0', code)
+
+    def test8_name_trie_repeated_spellings(self):
+        # the first symbol wins, the same as with the linear search
+        t = regen.EnumNameTrie(["FOO", "BAR", "FOO"])
+        self.assertEqual(t.find("FOO"), 0)
+        self.assertEqual(t.find("BAR"), 1)
+
+    def test9_bitmask_index(self):
+        e = regen.EnumBitmaskIndex.empty
+        # NONE, FOO, BAR, BAZ, FOO_BAR, FOO_BAR_BAZ
+        values = [0, 1, 2, 4, 3, 7]
+        bi = regen.EnumBitmaskIndex(values, 8)
+        self.assertTrue(bi.is_bitmask)
+        self.assertEqual(bi.composites, [5, 4])
+        self.assertEqual(bi.bits, [1, 2, 3])
+        self.assertEqual(bi.decompose(7), [5])
+        self.assertEqual(bi.decompose(3), [4])
+        self.assertEqual(bi.decompose(5), [1, 3])
+        self.assertEqual(bi.decompose(6), [2, 3])
+        self.assertEqual(bi.decompose(0), [])
+        self.assertIsNone(bi.decompose(8))
+        # the symbols are ordered by their lowest bit
+        bi = regen.EnumBitmaskIndex([4, 1, 2, 3], 8)
+        self.assertEqual(bi.decompose(7), [3, 0])
+        # the sign bit
+        bi = regen.EnumBitmaskIndex([1, 2, -2147483648], 32)
+        self.assertTrue(bi.is_bitmask)
+        self.assertEqual(bi.bits, [0, 1] + 29 * [e] + [2])
+        # repeated values: the last wins
+        bi = regen.EnumBitmaskIndex([1, 2, 3, 2, 3], 8)
+        self.assertEqual(bi.composites, [4, 2])
+        self.assertEqual(bi.bits[:2], [0, 3])
+        # not bitmasks
+        for values in ([0, 1], [1, 2, 4, 9], list(range(16)), [-1, 0, 1]):
+            bi = regen.EnumBitmaskIndex(values, 8)
+            self.assertFalse(bi.is_bitmask, values)
+
+    def test10_bitmask_lut(self):
+        # NONE, FOO, BAR, BAZ, FOO_BAR
+        bi = regen.EnumBitmaskIndex([0, 1, 2, 4, 3], 8)
+        lut = bi.lut(["NONE", "FOO", "BAR", "BAZ", "FOO_BAR"])
+        self.assertEqual(lut['num_bytes'], 1)
+        self.assertEqual(lut['mask'], 7)
+        # the last byte stops at the highest bit
+        self.assertEqual(lut['fragments'],
+                         ["", "FOO", "BAR", "FOO|BAR", "BAZ", "FOO|BAZ",
+                          "BAR|BAZ", "FOO|BAR|BAZ"])
+        self.assertEqual(lut['offs'], [0, 0, 3, 6, 13, 16, 23, 30, 41])
+        # bits with no symbol are left out of the mask
+        bi = regen.EnumBitmaskIndex([1, 1 << 9], 16)
+        lut = bi.lut(["A", "B"])
+        self.assertEqual(lut['num_bytes'], 2)
+        self.assertEqual(lut['mask'], 0x201)
+        self.assertEqual(len(lut['offs']), 256 + 4 + 1)
+        self.assertEqual(lut['fragments'][1], "A")
+        self.assertEqual(lut['fragments'][3], "A")
+        self.assertEqual(lut['fragments'][256 + 2], "B")
+
+    def test11_dense_index(self):
+        di = regen.EnumDenseIndex([3, 4, 5])
+        self.assertTrue(di.contiguous)
+        self.assertEqual((di.num, di.min), (3, 3))
+        self.assertEqual(di.find(5), 2)
+        self.assertIsNone(di.find(6))
+        # sparse values, in the order of the values; the first symbol wins
+        di = regen.EnumDenseIndex([100, -10, 1000, 100])
+        self.assertFalse(di.contiguous)
+        self.assertEqual(di.num, 3)
+        self.assertEqual(di.syms, [1, 0, 2])
+        self.assertEqual(di.find(100), 1)
+        self.assertIsNone(di.find(0))
+        di = regen.EnumDenseIndex([])
+        self.assertEqual(di.num, 0)
+
+
 # -----------------------------------------------------------------------------
 # -----------------------------------------------------------------------------
 # -----------------------------------------------------------------------------